@@ -0,0 +1,43 @@
+#!/bin/bash
+
+# measures the effect of --reorder-graph on cache misses per DP cell
+# usage: reorder_cache_misses.sh GraphAligner graph.gfa reads.fa [more GraphAligner parameters, default "-x vg"]
+# runs the aligner with and without --reorder-graph under perf stat, once with the reads and once without any reads
+# the run without reads only loads the graph and builds the seed index, its counts are subtracted so only the alignment is left
+# the DP cells come from the dp_cells line of --metrics-file
+
+set -e
+
+aligner=$1
+graph=$2
+reads=$3
+shift 3
+params="$@"
+if [ -z "$params" ]; then params="-x vg"; fi
+
+tmpdir=$(mktemp -d)
+trap "rm -rf $tmpdir" EXIT
+touch $tmpdir/empty.fa
+
+# perf stat -x, prints value,unit,event,...
+count() {
+	grep ",$2" $1 | head -n 1 | cut -d ',' -f 1
+}
+
+run() {
+	perf stat -x, -e cache-misses,cycles,instructions -o $tmpdir/perf_$1.txt $aligner -g $graph -f $2 -a $tmpdir/out_$1.gaf --metrics-file $tmpdir/metrics_$1.tsv $params $3 > /dev/null 2> $tmpdir/stderr_$1.txt || true
+}
+
+run plain $reads ""
+run plain_empty $tmpdir/empty.fa ""
+run reorder $reads "--reorder-graph"
+run reorder_empty $tmpdir/empty.fa "--reorder-graph"
+
+echo -e "mode\tdp_cells\tcache_misses\tcycles\tinstructions\tmisses_per_1000_cells\tcycles_per_cell"
+for mode in plain reorder; do
+	cells=$(grep "^dp_cells" $tmpdir/metrics_$mode.tsv | cut -f 3)
+	misses=$(( $(count $tmpdir/perf_$mode.txt cache-misses) - $(count $tmpdir/perf_${mode}_empty.txt cache-misses) ))
+	cycles=$(( $(count $tmpdir/perf_$mode.txt cycles) - $(count $tmpdir/perf_${mode}_empty.txt cycles) ))
+	instructions=$(( $(count $tmpdir/perf_$mode.txt instructions) - $(count $tmpdir/perf_${mode}_empty.txt instructions) ))
+	awk -v mode=$mode -v cells=$cells -v misses=$misses -v cycles=$cycles -v instructions=$instructions 'BEGIN { printf "%s\t%d\t%d\t%d\t%d\t%.3f\t%.3f\n", mode, cells, misses, cycles, instructions, misses * 1000 / cells, cycles / cells }'
+done
@@ -4,7 +4,10 @@
 #include <functional>
 #include <algorithm>
 #include <thread>
+#include <memory>
+#include <sys/stat.h>
 #include <concurrentqueue.h> //https://github.com/cameron314/concurrentqueue
+#include <blockingconcurrentqueue.h>
 #include <google/protobuf/util/json_util.h>
 #include "Aligner.h"
 #include "CommonUtils.h"
@@ -18,6 +21,8 @@
 #include "ReadCorrection.h"
 #include "MinimizerSeeder.h"
 #include "AlignmentSelection.h"
+#include "ReadMetrics.h"
+#include "OutputBuffer.h"
 
 struct Seeder
 {
@@ -162,29 +167,49 @@ void replaceDigraphNodeIdsWithOriginalNodeIds(vg::Alignment& alignment, const Al
 	}
 }
 
-void readFastqs(const std::vector<std::string>& filenames, moodycamel::ConcurrentQueue<std::shared_ptr<FastQ>>& writequeue, std::atomic<bool>& readStreamingFinished)
+//reads are handed to the aligner threads in batches of roughly this many bp
+constexpr size_t ReadBatchBp = 50000;
+
+//batches are recycled between the reader and the aligner threads so the read strings keep their capacity
+struct ReadBatch
+{
+	std::vector<FastQ> reads;
+	size_t numReads = 0;
+	size_t numBp = 0;
+};
+
+void readFastqs(const std::vector<std::string>& filenames, moodycamel::BlockingConcurrentQueue<ReadBatch*>& fullBatches, moodycamel::BlockingConcurrentQueue<ReadBatch*>& emptyBatches, size_t numAlignerThreads)
 {
 	assertSetNoRead("Read streamer");
+	ReadBatch* batch = nullptr;
+	emptyBatches.wait_dequeue(batch);
+	batch->numReads = 0;
+	batch->numBp = 0;
 	for (auto filename : filenames)
 	{
-		FastQ::streamFastqFromFile(filename, false, [&writequeue](FastQ& read)
+		FastQ::streamFastqFromFile(filename, false, [&batch, &fullBatches, &emptyBatches](FastQ& read)
 		{
-			std::shared_ptr<FastQ> ptr = std::make_shared<FastQ>();
-			std::swap(*ptr, read);
-			size_t slept = 0;
-			while (writequeue.size_approx() > 200)
-			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(10));
-				slept++;
-				if (slept > 100) break;
-			}
-			writequeue.enqueue(ptr);
+			if (batch->numReads == batch->reads.size()) batch->reads.emplace_back();
+			std::swap(batch->reads[batch->numReads], read);
+			batch->numBp += batch->reads[batch->numReads].sequence.size();
+			batch->numReads += 1;
+			if (batch->numBp < ReadBatchBp) return;
+			fullBatches.enqueue(batch);
+			//blocks until an aligner thread has finished a batch
+			emptyBatches.wait_dequeue(batch);
+			batch->numReads = 0;
+			batch->numBp = 0;
 		});
 	}
-	readStreamingFinished = true;
+	if (batch->numReads > 0) fullBatches.enqueue(batch);
+	//one end marker per aligner thread
+	for (size_t i = 0; i < numAlignerThreads; i++)
+	{
+		fullBatches.enqueue(nullptr);
+	}
 }
 
-void consumeBytesAndWrite(const std::string& filename, moodycamel::ConcurrentQueue<std::string*>& writequeue, moodycamel::ConcurrentQueue<std::string*>& deallocqueue, std::atomic<bool>& allThreadsDone, std::atomic<bool>& allWriteDone, bool verboseMode, bool textMode)
+void consumeBytesAndWrite(const std::string& filename, OutputQueue& writequeue, std::atomic<bool>& allThreadsDone, std::atomic<bool>& allWriteDone, bool verboseMode, bool textMode)
 {
 	assertSetNoRead("Writer");
 	auto openmode = std::ios::out;
@@ -203,23 +228,20 @@ void consumeBytesAndWrite(const std::string& filename, moodycamel::ConcurrentQue
 
 	while (true)
 	{
-		size_t gotAlns = writequeue.try_dequeue_bulk(alns, 100);
+		//the aligner threads have flushed everything before allThreadsDone is set, so check it before trying to get buffers
+		bool done = allThreadsDone;
+		size_t gotAlns = writequeue.getFull(alns, 100, std::chrono::milliseconds(10));
 		if (gotAlns == 0)
 		{
-			if (!writequeue.try_dequeue(alns[0]))
-			{
-				if (allThreadsDone) break;
-				std::this_thread::sleep_for(std::chrono::milliseconds(10));
-				continue;
-			}
-			gotAlns = 1;
+			if (done) break;
+			continue;
 		}
-		coutoutput << "write " << gotAlns << ", " << writequeue.size_approx() << " left" << BufferedWriter::Flush;
+		coutoutput << "write " << gotAlns << ", " << writequeue.fullBufferCount() << " left" << BufferedWriter::Flush;
 		for (size_t i = 0; i < gotAlns; i++)
 		{
 			outfile.write(alns[i]->data(), alns[i]->size());
+			writequeue.recycle(alns[i]);
 		}
-		deallocqueue.enqueue_bulk(alns, gotAlns);
 		wroteAny = true;
 	}
 
@@ -240,82 +262,64 @@ void consumeBytesAndWrite(const std::string& filename, moodycamel::ConcurrentQue
 	allWriteDone = true;
 }
 
-void QueueInsertSlowly(moodycamel::ProducerToken& token, moodycamel::ConcurrentQueue<std::string*>& queue, std::string&& str)
+void writeGAMToQueue(ThreadOutputBuffer& alignmentsOut, const AlignerParams& params, const AlignmentResult& alignments)
 {
-	std::string* write = new std::string { std::move(str) };
-	size_t waited = 0;
-	while (!queue.try_enqueue(token, write) && !queue.try_enqueue(token, write))
+	alignmentsOut.append([&alignments](std::string& out)
 	{
-		if (queue.size_approx() < 100 && queue.enqueue(token, write)) break;
-		std::this_thread::sleep_for(std::chrono::milliseconds(10));
-		waited++;
-		if (waited >= 10)
+		//each read is its own gzip member appended directly to the buffer
+		::google::protobuf::io::ZeroCopyOutputStream *raw_out = new ::google::protobuf::io::StringOutputStream(&out);
+		::google::protobuf::io::GzipOutputStream *gzip_out = new ::google::protobuf::io::GzipOutputStream(raw_out);
+		::google::protobuf::io::CodedOutputStream *coded_out = new ::google::protobuf::io::CodedOutputStream(gzip_out);
+		coded_out->WriteVarint64(alignments.alignments.size());
+		std::string s;
+		for (size_t i = 0; i < alignments.alignments.size(); i++)
 		{
-			if (queue.enqueue(token, write)) break;
+			assert(!alignments.alignments[i].alignmentFailed());
+			assert(alignments.alignments[i].alignment != nullptr);
+			alignments.alignments[i].alignment->SerializeToString(&s);
+			coded_out->WriteVarint32(s.size());
+			coded_out->WriteRaw(s.data(), s.size());
 		}
-	}
-}
-
-void writeGAMToQueue(moodycamel::ProducerToken& token, const AlignerParams& params, moodycamel::ConcurrentQueue<std::string*>& alignmentsOut, const AlignmentResult& alignments)
-{
-	std::stringstream strstr;
-	::google::protobuf::io::ZeroCopyOutputStream *raw_out = new ::google::protobuf::io::OstreamOutputStream(&strstr);
-	::google::protobuf::io::GzipOutputStream *gzip_out = new ::google::protobuf::io::GzipOutputStream(raw_out);
-	::google::protobuf::io::CodedOutputStream *coded_out = new ::google::protobuf::io::CodedOutputStream(gzip_out);
-	coded_out->WriteVarint64(alignments.alignments.size());
-	for (size_t i = 0; i < alignments.alignments.size(); i++)
-	{
-		assert(!alignments.alignments[i].alignmentFailed());
-		assert(alignments.alignments[i].alignment != nullptr);
-		std::string s;
-		alignments.alignments[i].alignment->SerializeToString(&s);
-		coded_out->WriteVarint32(s.size());
-		coded_out->WriteRaw(s.data(), s.size());
-	}
-	delete coded_out;
-	delete gzip_out;
-	delete raw_out;
-	QueueInsertSlowly(token, alignmentsOut, strstr.str());
+		delete coded_out;
+		delete gzip_out;
+		delete raw_out;
+	});
 }
 
-void writeJSONToQueue(moodycamel::ProducerToken& token, const AlignerParams& params, moodycamel::ConcurrentQueue<std::string*>& alignmentsOut, const AlignmentResult& alignments)
+void writeJSONToQueue(ThreadOutputBuffer& alignmentsOut, const AlignerParams& params, const AlignmentResult& alignments)
 {
-	std::stringstream strstr;
-	google::protobuf::util::JsonPrintOptions options;
-	options.preserve_proto_field_names = true;
-	for (size_t i = 0; i < alignments.alignments.size(); i++)
+	alignmentsOut.append([&alignments](std::string& out)
 	{
-		assert(!alignments.alignments[i].alignmentFailed());
-		assert(alignments.alignments[i].alignment != nullptr);
+		google::protobuf::util::JsonPrintOptions options;
+		options.preserve_proto_field_names = true;
 		std::string s;
-		google::protobuf::util::MessageToJsonString(*alignments.alignments[i].alignment, &s, options);
-		strstr << s;
-		strstr << '\n';
-	}
-	QueueInsertSlowly(token, alignmentsOut, strstr.str());
+		for (size_t i = 0; i < alignments.alignments.size(); i++)
+		{
+			assert(!alignments.alignments[i].alignmentFailed());
+			assert(alignments.alignments[i].alignment != nullptr);
+			s.clear();
+			google::protobuf::util::MessageToJsonString(*alignments.alignments[i].alignment, &s, options);
+			out += s;
+			out += '\n';
+		}
+	});
 }
 
-void writeGAFToQueue(moodycamel::ProducerToken& token, const AlignerParams& params, moodycamel::ConcurrentQueue<std::string*>& alignmentsOut, const AlignmentResult& alignments)
+void writeGAFToQueue(ThreadOutputBuffer& alignmentsOut, const AlignerParams& params, const AlignmentGraph& alignmentGraph, const std::string& readName, const std::string& sequence, const AlignmentResult& alignments)
 {
-	std::stringstream strstr;
-	for (size_t i = 0; i < alignments.alignments.size(); i++)
+	alignmentsOut.append([&params, &alignmentGraph, &readName, &sequence, &alignments](std::string& out)
 	{
-		assert(!alignments.alignments[i].alignmentFailed());
-		assert(alignments.alignments[i].GAFline.size() > 0);
-		strstr << alignments.alignments[i].GAFline;
-		strstr << '\n';
-	}
-	QueueInsertSlowly(token, alignmentsOut, strstr.str());
+		for (size_t i = 0; i < alignments.alignments.size(); i++)
+		{
+			assert(!alignments.alignments[i].alignmentFailed());
+			AddGAFLine(alignmentGraph, readName, sequence, alignments.alignments[i], params.cigarMatchMismatchMerge, out);
+			out += '\n';
+		}
+	});
 }
 
-void writeCorrectedToQueue(moodycamel::ProducerToken& token, const AlignerParams& params, const std::string& readName, const std::string& original, size_t maxOverlap, moodycamel::ConcurrentQueue<std::string*>& correctedOut, const AlignmentResult& alignments)
+void writeCorrectedToQueue(ThreadOutputBuffer& correctedOut, const AlignerParams& params, const std::string& readName, const std::string& original, size_t maxOverlap, const AlignmentResult& alignments)
 {
-	std::stringstream strstr;
-	zstr::ostream *compressed;
-	if (params.compressCorrected)
-	{
-		compressed = new zstr::ostream(strstr);
-	}
 	std::vector<Correction> corrections;
 	for (size_t i = 0; i < alignments.alignments.size(); i++)
 	{
@@ -327,59 +331,111 @@ void writeCorrectedToQueue(moodycamel::ProducerToken& token, const AlignerParams
 		corrections.back().corrected = alignments.alignments[i].corrected;
 	}
 	std::string corrected = getCorrected(original, corrections, maxOverlap);
-	if (params.compressCorrected)
-	{
-		(*compressed) << ">" << readName << std::endl;
-		(*compressed) << corrected << std::endl;
-		delete compressed;
-	}
-	else
+	correctedOut.append([&params, &readName, &corrected](std::string& out)
 	{
-		strstr << ">" << readName << std::endl;
-		strstr << corrected << std::endl;
-	}
-	QueueInsertSlowly(token, correctedOut, strstr.str());
+		if (params.compressCorrected)
+		{
+			std::stringstream strstr;
+			{
+				zstr::ostream compressed { strstr };
+				compressed << ">" << readName << std::endl;
+				compressed << corrected << std::endl;
+			}
+			out += strstr.str();
+		}
+		else
+		{
+			out += '>';
+			out += readName;
+			out += '\n';
+			out += corrected;
+			out += '\n';
+		}
+	});
 }
 
-void writeCorrectedClippedToQueue(moodycamel::ProducerToken& token, const AlignerParams& params, moodycamel::ConcurrentQueue<std::string*>& correctedClippedOut, const AlignmentResult& alignments)
+void writeCorrectedClippedToQueue(ThreadOutputBuffer& correctedClippedOut, const AlignerParams& params, const AlignmentResult& alignments)
 {
-	std::stringstream strstr;
-	zstr::ostream *compressed;
-	if (params.compressClipped)
+	correctedClippedOut.append([&params, &alignments](std::string& out)
 	{
-		compressed = new zstr::ostream(strstr);
-	}
-	for (size_t i = 0; i < alignments.alignments.size(); i++)
-	{
-		assert(!alignments.alignments[i].alignmentFailed());
-		assert(alignments.alignments[i].corrected.size() > 0);
 		if (params.compressClipped)
 		{
-			(*compressed) << ">" << alignments.readName << "_" << i << "_" << alignments.alignments[i].alignmentStart << "_" << alignments.alignments[i].alignmentEnd << std::endl;
-			(*compressed) << alignments.alignments[i].corrected << std::endl;
+			std::stringstream strstr;
+			{
+				zstr::ostream compressed { strstr };
+				for (size_t i = 0; i < alignments.alignments.size(); i++)
+				{
+					assert(!alignments.alignments[i].alignmentFailed());
+					assert(alignments.alignments[i].corrected.size() > 0);
+					compressed << ">" << alignments.readName << "_" << i << "_" << alignments.alignments[i].alignmentStart << "_" << alignments.alignments[i].alignmentEnd << std::endl;
+					compressed << alignments.alignments[i].corrected << std::endl;
+				}
+			}
+			out += strstr.str();
 		}
 		else
 		{
-			strstr << ">" << alignments.readName << "_" << i << "_" << alignments.alignments[i].alignmentStart << "_" << alignments.alignments[i].alignmentEnd << std::endl;
-			strstr << alignments.alignments[i].corrected << std::endl;
+			for (size_t i = 0; i < alignments.alignments.size(); i++)
+			{
+				assert(!alignments.alignments[i].alignmentFailed());
+				assert(alignments.alignments[i].corrected.size() > 0);
+				out += '>';
+				out += alignments.readName;
+				out += '_';
+				out += std::to_string(i);
+				out += '_';
+				out += std::to_string(alignments.alignments[i].alignmentStart);
+				out += '_';
+				out += std::to_string(alignments.alignments[i].alignmentEnd);
+				out += '\n';
+				out += alignments.alignments[i].corrected;
+				out += '\n';
+			}
 		}
+	});
+}
+
+//an alignment state leased from the shared pool for the duration of one read
+template <typename State>
+class StateLease
+{
+public:
+	StateLease(State* ownState, moodycamel::BlockingConcurrentQueue<State*>& sharedStates) :
+	state(ownState),
+	sharedStates(sharedStates),
+	shared(ownState == nullptr)
+	{
+		if (shared) sharedStates.wait_dequeue(state);
+		assert(state != nullptr);
 	}
-	if (params.compressClipped)
+	StateLease(const StateLease& other) = delete;
+	StateLease& operator=(const StateLease& other) = delete;
+	~StateLease()
 	{
-		delete compressed;
+		if (shared) sharedStates.enqueue(state);
 	}
-	QueueInsertSlowly(token, correctedClippedOut, strstr.str());
-}
+	State& get()
+	{
+		return *state;
+	}
+private:
+	State* state;
+	moodycamel::BlockingConcurrentQueue<State*>& sharedStates;
+	bool shared;
+};
 
-void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::ConcurrentQueue<std::shared_ptr<FastQ>>& readFastqsQueue, std::atomic<bool>& readStreamingFinished, int threadnum, const Seeder& seeder, AlignerParams params, moodycamel::ConcurrentQueue<std::string*>& GAMOut, moodycamel::ConcurrentQueue<std::string*>& JSONOut, moodycamel::ConcurrentQueue<std::string*>& GAFOut, moodycamel::ConcurrentQueue<std::string*>& correctedOut, moodycamel::ConcurrentQueue<std::string*>& correctedClippedOut, moodycamel::ConcurrentQueue<std::string*>& deallocqueue, AlignmentStats& stats)
+template <typename LengthType, typename Word>
+void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::BlockingConcurrentQueue<ReadBatch*>& fullBatches, moodycamel::BlockingConcurrentQueue<ReadBatch*>& emptyBatches, int threadnum, const Seeder& seeder, AlignerParams params, AlignerHelperPool<typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState>& helperPool, moodycamel::BlockingConcurrentQueue<typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState*>& sharedStates, OutputQueue& GAMQueue, OutputQueue& JSONQueue, OutputQueue& GAFQueue, OutputQueue& correctedQueue, OutputQueue& correctedClippedQueue, AlignmentStats& stats, ReadMetrics::ThreadMetrics& metrics)
 {
-	moodycamel::ProducerToken GAMToken { GAMOut };
-	moodycamel::ProducerToken JSONToken { JSONOut };
-	moodycamel::ProducerToken GAFToken { GAFOut };
-	moodycamel::ProducerToken correctedToken { correctedOut };
-	moodycamel::ProducerToken clippedToken { correctedClippedOut };
+	ThreadOutputBuffer GAMOut { GAMQueue };
+	ThreadOutputBuffer JSONOut { JSONQueue };
+	ThreadOutputBuffer GAFOut { GAFQueue };
+	ThreadOutputBuffer correctedOut { correctedQueue };
+	ThreadOutputBuffer correctedClippedOut { correctedClippedQueue };
 	assertSetNoRead("Before any read");
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState reusableState { alignmentGraph, std::max(params.initialBandwidth, params.rampBandwidth), !params.highMemory };
+	//with shared states the thread leases one from sharedStates for each read instead
+	std::unique_ptr<typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState> ownState;
+	if (params.alignmentStates == 0) ownState = std::make_unique<typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState>(alignmentGraph, std::max(params.initialBandwidth, params.rampBandwidth), !params.highMemory, params.sparseState, params.maxTableMemory * 1024 * 1024);
 	AlignmentSelection::SelectionOptions selectionOptions;
 	selectionOptions.method = params.alignmentSelectionMethod;
 	selectionOptions.graphSize = alignmentGraph.SizeInBP();
@@ -402,22 +458,45 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 		cerroutput = {std::cerr};
 		coutoutput = {std::cout};
 	}
+	moodycamel::ConsumerToken batchToken { fullBatches };
+	ReadBatch* batch = nullptr;
+	size_t batchPos = 0;
 	while (true)
 	{
-		std::string* dealloc;
-		while (deallocqueue.try_dequeue(dealloc))
+		if (batch != nullptr && batchPos == batch->numReads)
 		{
-			delete dealloc;
+			emptyBatches.enqueue(batch);
+			batch = nullptr;
 		}
-		std::shared_ptr<FastQ> fastq = nullptr;
-		while (fastq == nullptr && !readFastqsQueue.try_dequeue(fastq))
+		auto waitStart = std::chrono::steady_clock::now();
+		if (batch == nullptr)
 		{
-			bool tryBreaking = readStreamingFinished;
-			if (!readFastqsQueue.try_dequeue(fastq) && tryBreaking) break;
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			fullBatches.wait_dequeue(batchToken, batch);
+			batchPos = 0;
+			//end marker
+			if (batch == nullptr)
+			{
+				//help the threads which are still aligning long reads
+				//a helper holding a shared state could starve a thread which is still aligning, so those don't help
+				if (ownState != nullptr)
+				{
+					helperPool.help(*ownState);
+				}
+				else
+				{
+					helperPool.finishWithoutHelping();
+				}
+				break;
+			}
 		}
-		if (fastq == nullptr) break;
+		const FastQ* fastq = &batch->reads[batchPos];
+		batchPos += 1;
 		assertSetNoRead(fastq->seq_id);
+		StateLease<typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState> stateLease { ownState.get(), sharedStates };
+		auto& reusableState = stateLease.get();
+		metrics.record(ReadMetrics::QueueWaitTime, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - waitStart).count());
+		reusableState.counters.clear();
+		reusableState.arena.clearCounters();
 		coutoutput << "Read " << fastq->seq_id << " size " << fastq->sequence.size() << "bp" << BufferedWriter::Flush;
 		selectionOptions.readSize = fastq->sequence.size();
 		stats.reads += 1;
@@ -426,6 +505,7 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 		AlignmentResult alignments;
 
 		size_t alntimems = 0;
+		size_t alntimeus = 0;
 		size_t clustertimems = 0;
 		try
 		{
@@ -435,6 +515,7 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 				std::vector<SeedHit> seeds = seeder.getSeeds(fastq->seq_id, fastq->sequence);
 				auto timeEnd = std::chrono::system_clock::now();
 				size_t time = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart).count();
+				metrics.record(ReadMetrics::SeedingTime, std::chrono::duration_cast<std::chrono::microseconds>(timeEnd - timeStart).count());
 				coutoutput << "Read " << fastq->seq_id << " seeding took " << time << "ms" << BufferedWriter::Flush;
 				stats.seeds += seeds.size();
 				if (seeds.size() == 0)
@@ -443,7 +524,7 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 					cerroutput << "Read " << fastq->seq_id << " has no seed hits" << BufferedWriter::Flush;
 					coutoutput << "Read " << fastq->seq_id << " alignment failed" << BufferedWriter::Flush;
 					cerroutput << "Read " << fastq->seq_id << " alignment failed" << BufferedWriter::Flush;
-					if (params.outputCorrectedFile != "") writeCorrectedToQueue(correctedToken, params, fastq->seq_id, fastq->sequence, alignmentGraph.getDBGoverlap(), correctedOut, alignments);
+					if (params.outputCorrectedFile != "") writeCorrectedToQueue(correctedOut, params, fastq->seq_id, fastq->sequence, alignmentGraph.getDBGoverlap(), alignments);
 					continue;
 				}
 				stats.seedsFound += seeds.size();
@@ -460,33 +541,37 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 				}
 				auto clusterTimeEnd = std::chrono::system_clock::now();
 				size_t clusterTime = std::chrono::duration_cast<std::chrono::milliseconds>(clusterTimeEnd - clusterTimeStart).count();
+				metrics.record(ReadMetrics::ClusteringTime, std::chrono::duration_cast<std::chrono::microseconds>(clusterTimeEnd - clusterTimeStart).count());
 				coutoutput << "Read " << fastq->seq_id << " clustering took " << clusterTime << "ms" << BufferedWriter::Flush;
 				auto alntimeStart = std::chrono::system_clock::now();
 				if (params.multiseedDP)
 				{
-					alignments = AlignMultiseed(alignmentGraph, fastq->seq_id, fastq->sequence, params.initialBandwidth, params.rampBandwidth, params.maxCellsPerSlice, !params.verboseMode, !params.tryAllSeeds, seeds, reusableState, !params.highMemory, params.forceGlobal, params.preciseClipping, params.seedClusterMinSize, params.seedExtendDensity, params.nondeterministicOptimizations, params.preciseClippingIdentityCutoff, params.Xdropcutoff, params.multimapScoreFraction);
+					alignments = AlignMultiseed<LengthType, Word>(alignmentGraph, fastq->seq_id, fastq->sequence, params.initialBandwidth, params.rampBandwidth, params.maxCellsPerSlice, !params.verboseMode, !params.tryAllSeeds, seeds, reusableState, !params.highMemory, params.forceGlobal, params.preciseClipping, params.seedClusterMinSize, params.seedExtendDensity, params.nondeterministicOptimizations, params.preciseClippingIdentityCutoff, params.Xdropcutoff, params.multimapScoreFraction);
 					AlignmentSelection::AddMappingQualities(alignments.alignments);
 				}
 				else
 				{
-					alignments = AlignOneWay(alignmentGraph, fastq->seq_id, fastq->sequence, params.initialBandwidth, params.rampBandwidth, params.maxCellsPerSlice, !params.verboseMode, !params.tryAllSeeds, seeds, reusableState, !params.highMemory, params.forceGlobal, params.preciseClipping, params.seedClusterMinSize, params.seedExtendDensity, params.nondeterministicOptimizations, params.preciseClippingIdentityCutoff, params.Xdropcutoff);
+					alignments = AlignOneWay<LengthType, Word>(alignmentGraph, fastq->seq_id, fastq->sequence, params.initialBandwidth, params.rampBandwidth, params.maxCellsPerSlice, !params.verboseMode, !params.tryAllSeeds, seeds, reusableState, !params.highMemory, params.forceGlobal, params.preciseClipping, params.seedClusterMinSize, params.seedExtendDensity, params.nondeterministicOptimizations, params.preciseClippingIdentityCutoff, params.Xdropcutoff, &helperPool);
 				}
 				auto alntimeEnd = std::chrono::system_clock::now();
 				alntimems = std::chrono::duration_cast<std::chrono::milliseconds>(alntimeEnd - alntimeStart).count();
+				alntimeus = std::chrono::duration_cast<std::chrono::microseconds>(alntimeEnd - alntimeStart).count();
 			}
 			else if (params.optimalDijkstra)
 			{
 				auto alntimeStart = std::chrono::system_clock::now();
-				alignments = AlignOneWayDijkstra(alignmentGraph, fastq->seq_id, fastq->sequence, !params.verboseMode, reusableState, params.forceGlobal, params.preciseClipping);
+				alignments = AlignOneWayDijkstra<LengthType, Word>(alignmentGraph, fastq->seq_id, fastq->sequence, !params.verboseMode, reusableState, params.forceGlobal, params.preciseClipping, params.optimalHeuristicKmerLength);
 				auto alntimeEnd = std::chrono::system_clock::now();
 				alntimems = std::chrono::duration_cast<std::chrono::milliseconds>(alntimeEnd - alntimeStart).count();
+				alntimeus = std::chrono::duration_cast<std::chrono::microseconds>(alntimeEnd - alntimeStart).count();
 			}
 			else
 			{
 				auto alntimeStart = std::chrono::system_clock::now();
-				alignments = AlignOneWay(alignmentGraph, fastq->seq_id, fastq->sequence, params.initialBandwidth, params.rampBandwidth, !params.verboseMode, reusableState, !params.highMemory, params.forceGlobal, params.preciseClipping, params.nondeterministicOptimizations, params.preciseClippingIdentityCutoff, params.Xdropcutoff, params.DPRestartStride);
+				alignments = AlignOneWay<LengthType, Word>(alignmentGraph, fastq->seq_id, fastq->sequence, params.initialBandwidth, params.rampBandwidth, !params.verboseMode, reusableState, !params.highMemory, params.forceGlobal, params.preciseClipping, params.nondeterministicOptimizations, params.preciseClippingIdentityCutoff, params.Xdropcutoff, params.DPRestartStride);
 				auto alntimeEnd = std::chrono::system_clock::now();
 				alntimems = std::chrono::duration_cast<std::chrono::milliseconds>(alntimeEnd - alntimeStart).count();
+				alntimeus = std::chrono::duration_cast<std::chrono::microseconds>(alntimeEnd - alntimeStart).count();
 			}
 		}
 		catch (const ThreadReadAssertion::AssertionFailure& a)
@@ -500,8 +585,23 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 
 		stats.allAlignmentsCount += alignments.alignments.size();
 
+		size_t cellsProcessed = 0;
+		for (size_t i = 0; i < alignments.alignments.size(); i++)
+		{
+			cellsProcessed += alignments.alignments[i].cellsProcessed;
+		}
+		metrics.record(ReadMetrics::AlignmentTime, alntimeus);
+		metrics.record(ReadMetrics::BacktraceTime, reusableState.counters.backtraceMicroseconds);
+		metrics.record(ReadMetrics::DPCells, cellsProcessed);
+		metrics.record(ReadMetrics::Slices, reusableState.counters.slices);
+		metrics.record(ReadMetrics::BandRamps, reusableState.counters.bandRamps);
+		metrics.record(ReadMetrics::DPAllocations, reusableState.arena.allocations);
+		metrics.record(ReadMetrics::DPMallocs, reusableState.arena.systemAllocations);
+
 		coutoutput << "Read " << fastq->seq_id << " alignment took " << alntimems << "ms" << BufferedWriter::Flush;
+		auto selectionStart = std::chrono::steady_clock::now();
 		if (alignments.alignments.size() > 0) alignments.alignments = AlignmentSelection::SelectAlignments(alignments.alignments, selectionOptions);
+		metrics.record(ReadMetrics::SelectionTime, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - selectionStart).count());
 
 		//failed alignment, don't output
 		if (alignments.alignments.size() == 0)
@@ -510,7 +610,7 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 			cerroutput << "Read " << fastq->seq_id << " alignment failed" << BufferedWriter::Flush;
 			try
 			{
-				if (params.outputCorrectedFile != "") writeCorrectedToQueue(correctedToken, params, fastq->seq_id, fastq->sequence, alignmentGraph.getDBGoverlap(), correctedOut, alignments);
+				if (params.outputCorrectedFile != "") writeCorrectedToQueue(correctedOut, params, fastq->seq_id, fastq->sequence, alignmentGraph.getDBGoverlap(), alignments);
 			}
 			catch (const ThreadReadAssertion::AssertionFailure& a)
 			{
@@ -541,14 +641,6 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 			}
 		}
 
-		if (params.outputGAFFile != "")
-		{
-			for (size_t i = 0; i < alignments.alignments.size(); i++)
-			{
-				AddGAFLine(alignmentGraph, fastq->seq_id, fastq->sequence, alignments.alignments[i], params.cigarMatchMismatchMerge);
-			}
-		}
-		
 		std::sort(alignments.alignments.begin(), alignments.alignments.end(), [](const AlignmentResult::AlignmentItem& left, const AlignmentResult::AlignmentItem& right) { return left.alignmentStart < right.alignmentStart; });
 
 		std::string alignmentpositions;
@@ -563,7 +655,7 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 				stats.bpInFullAlignments += alignmentSize;
 			}
 			stats.bpInAlignments += alignmentSize;
-			if (params.outputCorrectedFile != "" || params.outputCorrectedClippedFile != "") AddCorrected(alignments.alignments[i]);
+			if (params.outputCorrectedFile != "" || params.outputCorrectedClippedFile != "") AddCorrected(alignmentGraph, alignments.alignments[i]);
 			alignmentpositions += std::to_string(alignments.alignments[i].alignmentStart) + "-" + std::to_string(alignments.alignments[i].alignmentEnd) + ", ";
 		}
 
@@ -571,13 +663,14 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 		alignmentpositions.pop_back();
 		coutoutput << "Read " << fastq->seq_id << " aligned by thread " << threadnum << " with positions: " << alignmentpositions << " (read " << fastq->sequence.size() << "bp)" << BufferedWriter::Flush;
 
+		auto serializationStart = std::chrono::steady_clock::now();
 		try
 		{
-			if (params.outputGAMFile != "") writeGAMToQueue(GAMToken, params, GAMOut, alignments);
-			if (params.outputJSONFile != "") writeJSONToQueue(JSONToken, params, JSONOut, alignments);
-			if (params.outputGAFFile != "") writeGAFToQueue(GAFToken, params, GAFOut, alignments);
-			if (params.outputCorrectedFile != "") writeCorrectedToQueue(correctedToken, params, fastq->seq_id, fastq->sequence, alignmentGraph.getDBGoverlap(), correctedOut, alignments);
-			if (params.outputCorrectedClippedFile != "") writeCorrectedClippedToQueue(clippedToken, params, correctedClippedOut, alignments);
+			if (params.outputGAMFile != "") writeGAMToQueue(GAMOut, params, alignments);
+			if (params.outputJSONFile != "") writeJSONToQueue(JSONOut, params, alignments);
+			if (params.outputGAFFile != "") writeGAFToQueue(GAFOut, params, alignmentGraph, fastq->seq_id, fastq->sequence, alignments);
+			if (params.outputCorrectedFile != "") writeCorrectedToQueue(correctedOut, params, fastq->seq_id, fastq->sequence, alignmentGraph.getDBGoverlap(), alignments);
+			if (params.outputCorrectedClippedFile != "") writeCorrectedClippedToQueue(correctedClippedOut, params, alignments);
 		}
 		catch (const ThreadReadAssertion::AssertionFailure& a)
 		{
@@ -585,13 +678,42 @@ void runComponentMappings(const AlignmentGraph& alignmentGraph, moodycamel::Conc
 			stats.assertionBroke = true;
 			continue;
 		}
+		metrics.record(ReadMetrics::SerializationTime, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - serializationStart).count());
 
 	}
+	GAMOut.flush();
+	JSONOut.flush();
+	GAFOut.flush();
+	correctedOut.flush();
+	correctedClippedOut.flush();
 	assertSetNoRead("After all reads");
 	coutoutput << "Thread " << threadnum << " finished" << BufferedWriter::Flush;
 }
 
-AlignmentGraph getGraph(std::string graphFile, MummerSeeder** mxmSeeder, const AlignerParams& params)
+template <typename LengthType, typename Word>
+void runAlignerThreads(const AlignmentGraph& alignmentGraph, moodycamel::BlockingConcurrentQueue<ReadBatch*>& fullReadBatches, moodycamel::BlockingConcurrentQueue<ReadBatch*>& emptyReadBatches, const Seeder& seeder, const AlignerParams& params, OutputQueue& outputGAM, OutputQueue& outputJSON, OutputQueue& outputGAF, OutputQueue& outputCorrected, OutputQueue& outputCorrectedClipped, AlignmentStats& stats, ReadMetrics::Registry& metrics)
+{
+	AlignerHelperPool<typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState> helperPool { params.numThreads };
+	std::vector<std::unique_ptr<typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState>> sharedStateStorage;
+	moodycamel::BlockingConcurrentQueue<typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState*> sharedStates;
+	for (size_t i = 0; i < params.alignmentStates; i++)
+	{
+		sharedStateStorage.emplace_back(std::make_unique<typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState>(alignmentGraph, std::max(params.initialBandwidth, params.rampBandwidth), !params.highMemory, params.sparseState, params.maxTableMemory * 1024 * 1024));
+		sharedStates.enqueue(sharedStateStorage.back().get());
+	}
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < params.numThreads; i++)
+	{
+		ReadMetrics::ThreadMetrics& threadMetrics = metrics.addThread();
+		threads.emplace_back([&alignmentGraph, &fullReadBatches, &emptyReadBatches, i, &seeder, &params, &helperPool, &sharedStates, &outputGAM, &outputJSON, &outputGAF, &outputCorrected, &outputCorrectedClipped, &stats, &threadMetrics]() { runComponentMappings<LengthType, Word>(alignmentGraph, fullReadBatches, emptyReadBatches, i, seeder, params, helperPool, sharedStates, outputGAM, outputJSON, outputGAF, outputCorrected, outputCorrectedClipped, stats, threadMetrics); });
+	}
+	for (size_t i = 0; i < params.numThreads; i++)
+	{
+		threads[i].join();
+	}
+}
+
+AlignmentGraph buildGraph(std::string graphFile, MummerSeeder** mxmSeeder, const AlignerParams& params)
 {
 	bool loadMxmSeeder = params.mumCount > 0 || params.memCount > 0;
 	if (is_file_exist(graphFile)){
@@ -624,15 +746,19 @@ AlignmentGraph getGraph(std::string graphFile, MummerSeeder** mxmSeeder, const A
 		}
 		else if (graphFile.substr(graphFile.size() - 4) == ".gfa")
 		{
-			auto graph = GfaGraph::LoadFromFile(graphFile, true);
 			if (loadMxmSeeder)
 			{
+				auto graph = GfaGraph::LoadFromFile(graphFile, true);
 				std::cout << "Build MUM/MEM seeder from the graph" << std::endl;
 				*mxmSeeder = new MummerSeeder { graph, params.seederCachePrefix };
+				std::cout << "Build alignment graph" << std::endl;
+				auto result = DirectedGraph::BuildFromGFA(graph);
+				return result;
+			}
+			else
+			{
+				return DirectedGraph::StreamGFAGraphFromFile(graphFile, params.numThreads);
 			}
-			std::cout << "Build alignment graph" << std::endl;
-			auto result = DirectedGraph::BuildFromGFA(graph);
-			return result;
 		}
 		else
 		{
@@ -648,6 +774,59 @@ AlignmentGraph getGraph(std::string graphFile, MummerSeeder** mxmSeeder, const A
 	}
 }
 
+//the graph file's path, size and modification time and the options which change the built graph
+std::string graphCacheSource(const std::string& graphFile, const AlignerParams& params)
+{
+	std::stringstream str;
+	str << graphFile;
+	struct stat fileStat;
+	if (stat(graphFile.c_str(), &fileStat) == 0)
+	{
+		str << " size " << fileStat.st_size << " mtime " << fileStat.st_mtim.tv_sec << "." << fileStat.st_mtim.tv_nsec;
+	}
+	str << " reorder " << (params.reorderGraph ? 1 : 0);
+	return str.str();
+}
+
+AlignmentGraph getGraph(std::string graphFile, MummerSeeder** mxmSeeder, const AlignerParams& params)
+{
+	bool loadMxmSeeder = params.mumCount > 0 || params.memCount > 0;
+	std::string cacheSource = graphCacheSource(graphFile, params);
+	bool cacheExists = params.graphCacheFile.size() > 0 && is_file_exist(params.graphCacheFile);
+	bool cacheMatches = cacheExists && AlignmentGraph::FileMatchesSource(params.graphCacheFile, cacheSource);
+	if (cacheExists && !cacheMatches)
+	{
+		std::cout << "Graph cache " << params.graphCacheFile << " was built from a different graph or with different options, rebuild it" << std::endl;
+	}
+	//mum/mem seeder is built from the original graph so the cache can't be used for it
+	if (cacheMatches && !loadMxmSeeder)
+	{
+		std::cout << "Load preprocessed graph from " << params.graphCacheFile << std::endl;
+		try
+		{
+			return AlignmentGraph::LoadFromFile(params.graphCacheFile);
+		}
+		catch (const CommonUtils::InvalidGraphException& e)
+		{
+			std::cout << "Error in the graph cache: " << e.what() << std::endl;
+			std::cerr << "Error in the graph cache: " << e.what() << std::endl;
+			std::exit(1);
+		}
+	}
+	auto result = buildGraph(graphFile, mxmSeeder, params);
+	if (params.reorderGraph)
+	{
+		std::cout << "Reorder graph nodes" << std::endl;
+		result.RenumberForLocality();
+	}
+	if (params.graphCacheFile.size() > 0 && !cacheMatches)
+	{
+		std::cout << "Store preprocessed graph to " << params.graphCacheFile << std::endl;
+		result.SaveToFile(params.graphCacheFile, cacheSource);
+	}
+	return result;
+}
+
 void alignReads(AlignerParams params)
 {
 	assertSetNoRead("Preprocessing");
@@ -661,7 +840,7 @@ void alignReads(AlignerParams params)
 	if (loadMinimizerSeeder)
 	{
 		std::cout << "Build minimizer seeder from the graph" << std::endl;
-		minimizerseeder = new MinimizerSeeder(alignmentGraph, params.minimizerLength, params.minimizerWindowSize, params.numThreads, 1.0 - params.minimizerDiscardMostNumerousFraction);
+		minimizerseeder = new MinimizerSeeder(alignmentGraph, params.minimizerLength, params.minimizerWindowSize, params.syncmerLength, params.numThreads, 1.0 - params.minimizerDiscardMostNumerousFraction, params.minimizerCachePrefix, params.minimizerBuildMemory * 1024 * 1024);
 		if (!minimizerseeder->canSeed())
 		{
 			std::cout << "Warning: Minimizer seeder has no seed hits. Reads cannot be aligned. Try unchopping the graph with vg or a different seeding mode" << std::endl;
@@ -715,6 +894,7 @@ void alignReads(AlignerParams params)
 			if (params.optimalDijkstra)
 			{
 				std::cout << "Optimal alignment. VERY SLOW!" << std::endl;
+				if (params.optimalHeuristicKmerLength > 0) std::cout << "Search guided by absent " << params.optimalHeuristicKmerLength << "-mers" << std::endl;
 			}
 			else
 			{
@@ -739,18 +919,25 @@ void alignReads(AlignerParams params)
 	if (params.outputCorrectedFile != "") std::cout << "write corrected reads to " << params.outputCorrectedFile << std::endl;
 	if (params.outputCorrectedClippedFile != "") std::cout << "write corrected & clipped reads to " << params.outputCorrectedClippedFile << std::endl;
 
-	std::vector<std::thread> threads;
-
 	assertSetNoRead("Running alignments");
 
-	moodycamel::ConcurrentQueue<std::string*> outputGAM { 50, params.numThreads, params.numThreads };
-	moodycamel::ConcurrentQueue<std::string*> outputGAF { 50, params.numThreads, params.numThreads };
-	moodycamel::ConcurrentQueue<std::string*> outputJSON { 50, params.numThreads, params.numThreads };
-	moodycamel::ConcurrentQueue<std::string*> deallocAlns;
-	moodycamel::ConcurrentQueue<std::string*> outputCorrected { 50, params.numThreads, params.numThreads };
-	moodycamel::ConcurrentQueue<std::string*> outputCorrectedClipped { 50, params.numThreads, params.numThreads };
-	moodycamel::ConcurrentQueue<std::shared_ptr<FastQ>> readFastqsQueue;
-	std::atomic<bool> readStreamingFinished { false };
+	//every thread holds at most one buffer per output, the rest are queued for or being written by the writer
+	const size_t outputBuffers = params.numThreads * 2 + 4;
+	const size_t outputBufferSize = 256 * 1024;
+	OutputQueue outputGAM { outputBuffers, outputBufferSize };
+	OutputQueue outputGAF { outputBuffers, outputBufferSize };
+	OutputQueue outputJSON { outputBuffers, outputBufferSize };
+	OutputQueue outputCorrected { outputBuffers, outputBufferSize };
+	OutputQueue outputCorrectedClipped { outputBuffers, outputBufferSize };
+	moodycamel::BlockingConcurrentQueue<ReadBatch*> fullReadBatches;
+	moodycamel::BlockingConcurrentQueue<ReadBatch*> emptyReadBatches;
+	//enough batches to keep every thread busy while the reader fills the next ones
+	std::vector<ReadBatch> readBatches;
+	readBatches.resize(params.numThreads * 2 + 2);
+	for (size_t i = 0; i < readBatches.size(); i++)
+	{
+		emptyReadBatches.enqueue(&readBatches[i]);
+	}
 	std::atomic<bool> allThreadsDone { false };
 	std::atomic<bool> GAMWriteDone { false };
 	std::atomic<bool> GAFWriteDone { false };
@@ -760,21 +947,44 @@ void alignReads(AlignerParams params)
 
 	std::cout << "Align" << std::endl;
 	AlignmentStats stats;
-	std::thread fastqThread { [files=params.fastqFiles, &readFastqsQueue, &readStreamingFinished]() { readFastqs(files, readFastqsQueue, readStreamingFinished); } };
-	std::thread GAMwriterThread { [file=params.outputGAMFile, &outputGAM, &deallocAlns, &allThreadsDone, &GAMWriteDone, verboseMode=params.verboseMode]() { if (file != "") consumeBytesAndWrite(file, outputGAM, deallocAlns, allThreadsDone, GAMWriteDone, verboseMode, false); else GAMWriteDone = true; } };
-	std::thread GAFwriterThread { [file=params.outputGAFFile, &outputGAF, &deallocAlns, &allThreadsDone, &GAFWriteDone, verboseMode=params.verboseMode]() { if (file != "") consumeBytesAndWrite(file, outputGAF, deallocAlns, allThreadsDone, GAFWriteDone, verboseMode, false); else GAFWriteDone = true; } };
-	std::thread JSONwriterThread { [file=params.outputJSONFile, &outputJSON, &deallocAlns, &allThreadsDone, &JSONWriteDone, verboseMode=params.verboseMode]() { if (file != "") consumeBytesAndWrite(file, outputJSON, deallocAlns, allThreadsDone, JSONWriteDone, verboseMode, true); else JSONWriteDone = true; } };
-	std::thread correctedWriterThread { [file=params.outputCorrectedFile, &outputCorrected, &deallocAlns, &allThreadsDone, &correctedWriteDone, verboseMode=params.verboseMode, uncompressed=!params.compressCorrected]() { if (file != "") consumeBytesAndWrite(file, outputCorrected, deallocAlns, allThreadsDone, correctedWriteDone, verboseMode, uncompressed); else correctedWriteDone = true; } };
-	std::thread correctedClippedWriterThread { [file=params.outputCorrectedClippedFile, &outputCorrectedClipped, &deallocAlns, &allThreadsDone, &correctedClippedWriteDone, verboseMode=params.verboseMode, uncompressed=!params.compressClipped]() { if (file != "") consumeBytesAndWrite(file, outputCorrectedClipped, deallocAlns, allThreadsDone, correctedClippedWriteDone, verboseMode, uncompressed); else correctedClippedWriteDone = true; } };
+	ReadMetrics::Registry metrics;
+	std::thread fastqThread { [files=params.fastqFiles, &fullReadBatches, &emptyReadBatches, numThreads=params.numThreads]() { readFastqs(files, fullReadBatches, emptyReadBatches, numThreads); } };
+	std::thread GAMwriterThread { [file=params.outputGAMFile, &outputGAM, &allThreadsDone, &GAMWriteDone, verboseMode=params.verboseMode]() { if (file != "") consumeBytesAndWrite(file, outputGAM, allThreadsDone, GAMWriteDone, verboseMode, false); else GAMWriteDone = true; } };
+	std::thread GAFwriterThread { [file=params.outputGAFFile, &outputGAF, &allThreadsDone, &GAFWriteDone, verboseMode=params.verboseMode]() { if (file != "") consumeBytesAndWrite(file, outputGAF, allThreadsDone, GAFWriteDone, verboseMode, false); else GAFWriteDone = true; } };
+	std::thread JSONwriterThread { [file=params.outputJSONFile, &outputJSON, &allThreadsDone, &JSONWriteDone, verboseMode=params.verboseMode]() { if (file != "") consumeBytesAndWrite(file, outputJSON, allThreadsDone, JSONWriteDone, verboseMode, true); else JSONWriteDone = true; } };
+	std::thread correctedWriterThread { [file=params.outputCorrectedFile, &outputCorrected, &allThreadsDone, &correctedWriteDone, verboseMode=params.verboseMode, uncompressed=!params.compressCorrected]() { if (file != "") consumeBytesAndWrite(file, outputCorrected, allThreadsDone, correctedWriteDone, verboseMode, uncompressed); else correctedWriteDone = true; } };
+	std::thread metricsThread { [file=params.metricsFile, interval=params.metricsInterval, &metrics, &allThreadsDone]()
+	{
+		if (file == "" || interval == 0) return;
+		auto lastWrite = std::chrono::steady_clock::now();
+		while (!allThreadsDone)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			if (std::chrono::steady_clock::now() - lastWrite < std::chrono::seconds(interval)) continue;
+			metrics.writeFile(file);
+			lastWrite = std::chrono::steady_clock::now();
+		}
+	} };
+	std::thread correctedClippedWriterThread { [file=params.outputCorrectedClippedFile, &outputCorrectedClipped, &allThreadsDone, &correctedClippedWriteDone, verboseMode=params.verboseMode, uncompressed=!params.compressClipped]() { if (file != "") consumeBytesAndWrite(file, outputCorrectedClipped, allThreadsDone, correctedClippedWriteDone, verboseMode, uncompressed); else correctedClippedWriteDone = true; } };
 
-	for (size_t i = 0; i < params.numThreads; i++)
+	//32-bit node indices and sequence positions make the queues, slices and node slice maps smaller
+	//the max value is used as a marker so the graph must have fewer nodes than that
+	bool smallIndices = alignmentGraph.NodeSize() < std::numeric_limits<uint32_t>::max();
+	if (params.wordSize == 128 && smallIndices)
 	{
-		threads.emplace_back([&alignmentGraph, &readFastqsQueue, &readStreamingFinished, i, seeder, params, &outputGAM, &outputJSON, &outputGAF, &outputCorrected, &outputCorrectedClipped, &deallocAlns, &stats]() { runComponentMappings(alignmentGraph, readFastqsQueue, readStreamingFinished, i, seeder, params, outputGAM, outputJSON, outputGAF, outputCorrected, outputCorrectedClipped, deallocAlns, stats); });
+		runAlignerThreads<uint32_t, __uint128_t>(alignmentGraph, fullReadBatches, emptyReadBatches, seeder, params, outputGAM, outputJSON, outputGAF, outputCorrected, outputCorrectedClipped, stats, metrics);
 	}
-
-	for (size_t i = 0; i < params.numThreads; i++)
+	else if (params.wordSize == 128)
 	{
-		threads[i].join();
+		runAlignerThreads<size_t, __uint128_t>(alignmentGraph, fullReadBatches, emptyReadBatches, seeder, params, outputGAM, outputJSON, outputGAF, outputCorrected, outputCorrectedClipped, stats, metrics);
+	}
+	else if (smallIndices)
+	{
+		runAlignerThreads<uint32_t, uint64_t>(alignmentGraph, fullReadBatches, emptyReadBatches, seeder, params, outputGAM, outputJSON, outputGAF, outputCorrected, outputCorrectedClipped, stats, metrics);
+	}
+	else
+	{
+		runAlignerThreads<size_t, uint64_t>(alignmentGraph, fullReadBatches, emptyReadBatches, seeder, params, outputGAM, outputJSON, outputGAF, outputCorrected, outputCorrectedClipped, stats, metrics);
 	}
 	assertSetNoRead("Postprocessing");
 
@@ -785,17 +995,14 @@ void alignReads(AlignerParams params)
 	JSONwriterThread.join();
 	correctedWriterThread.join();
 	correctedClippedWriterThread.join();
+	metricsThread.join();
 	fastqThread.join();
 
+	if (params.metricsFile != "") metrics.writeFile(params.metricsFile);
+
 	if (mummerseeder != nullptr) delete mummerseeder;
 	if (minimizerseeder != nullptr) delete minimizerseeder;
 
-	std::string* dealloc;
-	while (deallocAlns.try_dequeue(dealloc))
-	{
-		delete dealloc;
-	}
-
 	std::cout << "Alignment finished" << std::endl;
 	std::cout << "Input reads: " << stats.reads << " (" << stats.bpInReads << "bp)" << std::endl;
 	std::cout << "Seeds found: " << stats.seedsFound << std::endl;
@@ -10,6 +10,8 @@
 struct AlignerParams
 {
 	std::string graphFile;
+	std::string graphCacheFile;
+	bool reorderGraph;
 	std::vector<std::string> fastqFiles;
 	size_t numThreads;
 	size_t initialBandwidth;
@@ -25,10 +27,19 @@ struct AlignerParams
 	bool verboseMode;
 	bool tryAllSeeds;
 	bool highMemory;
+	bool sparseState;
+	size_t maxTableMemory;
+	size_t alignmentStates;
+	size_t wordSize;
+	std::string metricsFile;
+	size_t metricsInterval;
 	size_t mxmLength;
 	size_t mumCount;
 	size_t memCount;
 	std::string seederCachePrefix;
+	std::string minimizerCachePrefix;
+	size_t minimizerBuildMemory;
+	size_t syncmerLength;
 	AlignmentSelection::SelectionMethod alignmentSelectionMethod;
 	double selectionECutoff;
 	bool forceGlobal;
@@ -43,6 +54,7 @@ struct AlignerParams
 	double seedExtendDensity;
 	bool nondeterministicOptimizations;
 	bool optimalDijkstra;
+	size_t optimalHeuristicKmerLength;
 	double preciseClippingIdentityCutoff;
 	int Xdropcutoff;
 	size_t DPRestartStride;
@@ -0,0 +1,126 @@
+#ifndef AlignerHelperPool_h
+#define AlignerHelperPool_h
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include "ThreadReadAssertion.h"
+
+//aligner threads which have run out of reads wait here and run tasks split off from the reads other threads are still aligning
+//each thread brings its own State so tasks don't need to allocate a graph sized state
+template <typename State>
+class AlignerHelperPool
+{
+public:
+	AlignerHelperPool(size_t numThreads) :
+	mutex(),
+	taskAvailable(),
+	tasks(),
+	numThreads(numThreads),
+	numHelping(0),
+	numIdle(0),
+	finished(false)
+	{
+	}
+	AlignerHelperPool(const AlignerHelperPool& other) = delete;
+	AlignerHelperPool& operator=(const AlignerHelperPool& other) = delete;
+	size_t idleHelpers() const
+	{
+		return numIdle;
+	}
+	//the task is skipped if cancel is set before a thread picks it up
+	template <typename Result>
+	std::future<Result> submit(std::function<Result(State&)> task, std::shared_ptr<std::atomic<bool>> cancel)
+	{
+		auto promise = std::make_shared<std::promise<Result>>();
+		std::future<Result> result = promise->get_future();
+		{
+			std::lock_guard<std::mutex> guard { mutex };
+			tasks.emplace_back([task, promise, cancel](State& state)
+			{
+				if (*cancel)
+				{
+					promise->set_value(Result{});
+					return;
+				}
+				try
+				{
+					promise->set_value(task(state));
+				}
+				catch (const ThreadReadAssertion::AssertionFailure& a)
+				{
+					state.clear();
+					promise->set_exception(std::current_exception());
+				}
+			});
+		}
+		taskAvailable.notify_one();
+		return result;
+	}
+	//run one queued task with the caller's state, if there is one
+	bool tryRunTask(State& state)
+	{
+		std::function<void(State&)> task;
+		{
+			std::lock_guard<std::mutex> guard { mutex };
+			if (tasks.size() == 0) return false;
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task(state);
+		return true;
+	}
+	//called by a thread once it has no more reads but can't help. doesn't wait for the other threads
+	void finishWithoutHelping()
+	{
+		std::unique_lock<std::mutex> lock { mutex };
+		numHelping += 1;
+		if (numHelping == numThreads)
+		{
+			finished = true;
+			lock.unlock();
+			taskAvailable.notify_all();
+		}
+	}
+	//called by a thread once it has no more reads. returns when every thread has no more reads
+	void help(State& state)
+	{
+		assertSetNoRead("Helper");
+		std::unique_lock<std::mutex> lock { mutex };
+		numHelping += 1;
+		if (numHelping == numThreads)
+		{
+			finished = true;
+			lock.unlock();
+			taskAvailable.notify_all();
+			return;
+		}
+		while (true)
+		{
+			numIdle += 1;
+			taskAvailable.wait(lock, [this]() { return finished || tasks.size() > 0; });
+			numIdle -= 1;
+			if (finished && tasks.size() == 0) break;
+			auto task = std::move(tasks.front());
+			tasks.pop_front();
+			lock.unlock();
+			task(state);
+			assertSetNoRead("Helper");
+			lock.lock();
+		}
+	}
+private:
+	std::mutex mutex;
+	std::condition_variable taskAvailable;
+	std::deque<std::function<void(State&)>> tasks;
+	const size_t numThreads;
+	size_t numHelping;
+	std::atomic<size_t> numIdle;
+	bool finished;
+};
+
+#endif
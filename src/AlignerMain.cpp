@@ -9,6 +9,8 @@
 #include "stream.hpp"
 #include "ThreadReadAssertion.h"
 #include "EValue.h"
+#include "BitvectorSIMD.h"
+#include "SeedHeuristic.h"
 
 int main(int argc, char** argv)
 {
@@ -25,6 +27,7 @@ int main(int argc, char** argv)
 		std::abort();
 	}
 #endif
+	BitvectorSIMD::detectCPU();
 
 	struct sigaction act;
 	act.sa_handler = ThreadReadAssertion::signal;
@@ -53,6 +56,10 @@ int main(int argc, char** argv)
 		("version", "print version")
 		("threads,t", boost::program_options::value<size_t>(), "number of threads (int) (default 1)")
 		("verbose", "print progress messages")
+		("metrics-file", boost::program_options::value<std::string>(), "write per-read stage timing histograms to this file (.json/.tsv)")
+		("metrics-interval", boost::program_options::value<size_t>(), "rewrite the metrics file every arg seconds while aligning (int) (0 for only at the end)")
+		("graph-cache", boost::program_options::value<std::string>(), "store the preprocessed alignment graph to the disk for reuse, or reuse it if it exists (filename)")
+		("reorder-graph", "renumber the alignment graph so nodes which are aligned together are close in memory")
 		("E-cutoff", boost::program_options::value<double>(), "discard alignments with E-value > arg")
 		("min-alignment-score", boost::program_options::value<double>(), "discard alignments whose alignment score is < arg (default 0)")
 		("all-alignments", "return all alignments instead of the best non-overlapping alignments")
@@ -60,6 +67,7 @@ int main(int argc, char** argv)
 		("try-all-seeds", "don't use heuristics to discard seed hits")
 		("global-alignment", "force the read to be aligned end-to-end even if the alignment score is poor")
 		("optimal-alignment", "calculate the optimal alignment (VERY SLOW)")
+		("optimal-alignment-kmer", boost::program_options::value<size_t>(), "with --optimal-alignment, skip most of the search using a lower bound from the read's k-mers of length arg which are not in the graph. Still optimal (int) (0 for no bound)")
 		("X-drop", boost::program_options::value<int>(), "use X-drop heuristic to end alignment with score cutoff arg (int)")
 		("precise-clipping", boost::program_options::value<double>(), "clip the alignment ends more precisely with arg as the identity cutoff between correct / wrong alignments (float)")
 		("cigar-match-mismatch", "use M for matches and mismatches in the cigar string instead of = and X")
@@ -72,6 +80,9 @@ int main(int argc, char** argv)
 		("seeds-minimizer-windowsize", boost::program_options::value<size_t>(), "window size for minimizer seeding (int)")
 		("seeds-minimizer-density", boost::program_options::value<double>(), "keep approximately (arg * sequence length) least common minimizers (double) (-1 for all)")
 		("seeds-minimizer-ignore-frequent", boost::program_options::value<double>(), "ignore arg most frequent fraction of minimizers (double)")
+		("seeds-minimizer-cache-prefix", boost::program_options::value<std::string>(), "store the minimizer seeding index to the disk for reuse, or reuse it if it exists (filename prefix)")
+		("seeds-syncmer-length", boost::program_options::value<size_t>(), "index and look up open syncmers with s-mers of length arg instead of minimizers, 0 for minimizers (int)")
+		("seeds-minimizer-build-memory", boost::program_options::value<size_t>(), "keep the temporary minimizer arrays under arg megabytes while building the minimizer index, 0 for no limit (int)")
 		("seeds-mum-count", boost::program_options::value<size_t>(), "arg longest maximal unique matches fully contained in a node (int) (-1 for all)")
 		("seeds-mem-count", boost::program_options::value<size_t>(), "arg longest maximal exact matches fully contained in a node (int) (-1 for all)")
 		("seeds-mxm-length", boost::program_options::value<size_t>(), "minimum length for maximal unique / exact matches (int)")
@@ -86,6 +97,10 @@ int main(int argc, char** argv)
 		("ramp-bandwidth,B", boost::program_options::value<size_t>(), "ramp bandwidth (int)")
 		("tangle-effort,C", boost::program_options::value<size_t>(), "tangle effort limit, higher results in slower but more accurate alignments (int) (-1 for unlimited)")
 		("high-memory", "use slightly less CPU but a lot more memory")
+		("sparse-state", "store the per-thread alignment state proportional to the band instead of the graph size. Less memory on huge graphs but slightly slower")
+		("max-table-memory", boost::program_options::value<size_t>(), "per-thread memory limit in megabytes for the DP scores kept for the backtrace. Past it only some slices are kept and the rest are recomputed during backtrace (int) (0 for no limit)")
+		("alignment-states", boost::program_options::value<size_t>(), "share this many alignment states between the threads instead of one per thread (int) (0 for one per thread)")
+		("slice-height", boost::program_options::value<size_t>(), "bp per DP slice, 64 or 128. 128 can be faster for long accurate reads (int)")
 	;
 	boost::program_options::options_description hidden("hidden");
 	hidden.add_options()
@@ -137,16 +152,27 @@ int main(int argc, char** argv)
 	params.outputCorrectedClippedFile = "";
 	params.numThreads = 1;
 	params.initialBandwidth = 0;
+	params.graphCacheFile = "";
+	params.reorderGraph = false;
 	params.rampBandwidth = 0;
 	params.dynamicRowStart = false;
 	params.maxCellsPerSlice = std::numeric_limits<decltype(params.maxCellsPerSlice)>::max();
 	params.verboseMode = false;
 	params.tryAllSeeds = false;
 	params.highMemory = false;
+	params.sparseState = false;
+	params.maxTableMemory = 0;
+	params.alignmentStates = 0;
+	params.wordSize = 64;
+	params.metricsFile = "";
+	params.metricsInterval = 0;
 	params.mxmLength = 20;
 	params.mumCount = 0;
 	params.memCount = 0;
 	params.seederCachePrefix = "";
+	params.minimizerCachePrefix = "";
+	params.minimizerBuildMemory = 0;
+	params.syncmerLength = 0;
 	params.alignmentSelectionMethod = AlignmentSelection::SelectionMethod::GreedyLength; //todo pick better default
 	params.selectionECutoff = -1;
 	params.forceGlobal = false;
@@ -161,6 +187,7 @@ int main(int argc, char** argv)
 	params.seedExtendDensity = 0.002;
 	params.nondeterministicOptimizations = false;
 	params.optimalDijkstra = false;
+	params.optimalHeuristicKmerLength = 0;
 	params.preciseClippingIdentityCutoff = 0.5;
 	params.Xdropcutoff = 0;
 	params.DPRestartStride = 0;
@@ -222,6 +249,11 @@ int main(int argc, char** argv)
 	if (vm.count("seeds-mem-count")) params.memCount = vm["seeds-mem-count"].as<size_t>();
 	if (vm.count("seeds-mum-count")) params.mumCount = vm["seeds-mum-count"].as<size_t>();
 	if (vm.count("seeds-mxm-cache-prefix")) params.seederCachePrefix = vm["seeds-mxm-cache-prefix"].as<std::string>();
+	if (vm.count("seeds-minimizer-cache-prefix")) params.minimizerCachePrefix = vm["seeds-minimizer-cache-prefix"].as<std::string>();
+	if (vm.count("seeds-syncmer-length")) params.syncmerLength = vm["seeds-syncmer-length"].as<size_t>();
+	if (vm.count("seeds-minimizer-build-memory")) params.minimizerBuildMemory = vm["seeds-minimizer-build-memory"].as<size_t>();
+	if (vm.count("graph-cache")) params.graphCacheFile = vm["graph-cache"].as<std::string>();
+	if (vm.count("reorder-graph")) params.reorderGraph = true;
 	if (vm.count("seedless-DP")) params.dynamicRowStart = true;
 	if (vm.count("DP-restart-stride")) params.DPRestartStride = vm["DP-restart-stride"].as<size_t>();
 	if (vm.count("multiseed-DP")) params.multiseedDP = vm["multiseed-DP"].as<bool>();
@@ -275,6 +307,12 @@ int main(int argc, char** argv)
 	if (vm.count("verbose")) params.verboseMode = true;
 	if (vm.count("try-all-seeds")) params.tryAllSeeds = true;
 	if (vm.count("high-memory")) params.highMemory = true;
+	if (vm.count("sparse-state")) params.sparseState = true;
+	if (vm.count("max-table-memory")) params.maxTableMemory = vm["max-table-memory"].as<size_t>();
+	if (vm.count("alignment-states")) params.alignmentStates = vm["alignment-states"].as<size_t>();
+	if (vm.count("slice-height")) params.wordSize = vm["slice-height"].as<size_t>();
+	if (vm.count("metrics-file")) params.metricsFile = vm["metrics-file"].as<std::string>();
+	if (vm.count("metrics-interval")) params.metricsInterval = vm["metrics-interval"].as<size_t>();
 	if (vm.count("global-alignment")) params.forceGlobal = true;
 	if (vm.count("precise-clipping"))
 	{
@@ -300,6 +338,7 @@ int main(int argc, char** argv)
 		}
 	}
 	if (vm.count("optimal-alignment")) params.optimalDijkstra = true;
+	if (vm.count("optimal-alignment-kmer")) params.optimalHeuristicKmerLength = vm["optimal-alignment-kmer"].as<size_t>();
 
 	if (params.graphFile == "")
 	{
@@ -351,6 +390,21 @@ int main(int argc, char** argv)
 		std::cerr << "number of threads must be >= 1" << std::endl;
 		paramError = true;
 	}
+	if (params.wordSize != 64 && params.wordSize != 128)
+	{
+		std::cerr << "slice height must be 64 or 128" << std::endl;
+		paramError = true;
+	}
+	if (params.metricsInterval > 0 && params.metricsFile == "")
+	{
+		std::cerr << "--metrics-interval requires --metrics-file" << std::endl;
+		paramError = true;
+	}
+	if (params.sparseState && params.highMemory)
+	{
+		std::cerr << "--sparse-state can't be used with --high-memory" << std::endl;
+		paramError = true;
+	}
 	if (params.initialBandwidth < 1 && !params.optimalDijkstra)
 	{
 		std::cerr << "default bandwidth must be >= 1" << std::endl;
@@ -371,6 +425,11 @@ int main(int argc, char** argv)
 		std::cerr << "Maximum minimizer length is " << (sizeof(size_t)*8/2)-1 << std::endl;
 		paramError = true;
 	}
+	if (params.syncmerLength >= params.minimizerLength)
+	{
+		std::cerr << "Syncmer s-mer length must be shorter than the minimizer length" << std::endl;
+		paramError = true;
+	}
 	if (params.minimizerDiscardMostNumerousFraction < 0 || params.minimizerDiscardMostNumerousFraction >= 1)
 	{
 		std::cerr << "Minimizer discard fraction must be 0 <= x < 1" << std::endl;
@@ -397,6 +456,16 @@ int main(int argc, char** argv)
 		paramError = true;
 	}
 	int pickedSeedingMethods = ((params.dynamicRowStart) ? 1 : 0) + ((params.seedFiles.size() > 0) ? 1 : 0) + ((params.mumCount != 0) ? 1 : 0) + ((params.memCount != 0) ? 1 : 0) + ((params.minimizerSeedDensity != 0) ? 1 : 0);
+	if (params.optimalHeuristicKmerLength > 0 && !params.optimalDijkstra)
+	{
+		std::cerr << "--optimal-alignment-kmer requires --optimal-alignment" << std::endl;
+		paramError = true;
+	}
+	if (params.optimalHeuristicKmerLength > SeedHeuristic::MaxKmerLength)
+	{
+		std::cerr << "optimal alignment k-mer length must be <= " << SeedHeuristic::MaxKmerLength << std::endl;
+		paramError = true;
+	}
 	if (params.optimalDijkstra && (params.initialBandwidth > 0))
 	{
 		std::cerr << "--optimal-alignment set, ignoring parameter --bandwidth" << std::endl;
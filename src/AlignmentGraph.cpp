@@ -1,7 +1,15 @@
 #include <iostream>
+#include <fstream>
 #include <limits>
 #include <algorithm>
 #include <queue>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "AlignmentGraph.h"
 #include "CommonUtils.h"
 #include "ThreadReadAssertion.h"
@@ -17,7 +25,10 @@ AlignmentGraph::AlignmentGraph() :
 nodeLength(),
 nodeLookup(),
 nodeIDs(),
+inNeighborLists(),
+outNeighborLists(),
 inNeighbors(),
+outNeighbors(),
 nodeSequences(),
 bpSize(0),
 ambiguousNodeSequences(),
@@ -39,8 +50,8 @@ void AlignmentGraph::ReserveNodes(size_t numNodes, size_t numSplitNodes)
 	nodeLookup.reserve(numNodes);
 	nodeIDs.reserve(numSplitNodes);
 	nodeLength.reserve(numSplitNodes);
-	inNeighbors.reserve(numSplitNodes);
-	outNeighbors.reserve(numSplitNodes);
+	inNeighborLists.reserve(numSplitNodes);
+	outNeighborLists.reserve(numSplitNodes);
 	reverse.reserve(numSplitNodes);
 	nodeOffset.reserve(numSplitNodes);
 }
@@ -69,14 +80,14 @@ void AlignmentGraph::AddNode(int nodeId, const std::string& sequence, const std:
 			AddNode(nodeId, offset, sequence.substr(offset, size), reverseNode);
 			if (offset > 0)
 			{
-				assert(outNeighbors.size() >= 2);
-				assert(outNeighbors.size() == inNeighbors.size());
-				assert(nodeIDs.size() == outNeighbors.size());
-				assert(nodeOffset.size() == outNeighbors.size());
-				assert(nodeIDs[outNeighbors.size()-2] == nodeIDs[outNeighbors.size()-1]);
-				assert(nodeOffset[outNeighbors.size()-2] + nodeLength[outNeighbors.size()-2] == nodeOffset[outNeighbors.size()-1]);
-				outNeighbors[outNeighbors.size()-2].push_back(outNeighbors.size()-1);
-				inNeighbors[inNeighbors.size()-1].push_back(inNeighbors.size()-2);
+				assert(outNeighborLists.size() >= 2);
+				assert(outNeighborLists.size() == inNeighborLists.size());
+				assert(nodeIDs.size() == outNeighborLists.size());
+				assert(nodeOffset.size() == outNeighborLists.size());
+				assert(nodeIDs[outNeighborLists.size()-2] == nodeIDs[outNeighborLists.size()-1]);
+				assert(nodeOffset[outNeighborLists.size()-2] + nodeLength[outNeighborLists.size()-2] == nodeOffset[outNeighborLists.size()-1]);
+				outNeighborLists[outNeighborLists.size()-2].push_back(outNeighborLists.size()-1);
+				inNeighborLists[inNeighborLists.size()-1].push_back(inNeighborLists.size()-2);
 			}
 		}
 	}
@@ -92,8 +103,8 @@ void AlignmentGraph::AddNode(int nodeId, int offset, const std::string& sequence
 	nodeLookup[nodeId].push_back(nodeLength.size());
 	nodeLength.push_back(sequence.size());
 	nodeIDs.push_back(nodeId);
-	inNeighbors.emplace_back();
-	outNeighbors.emplace_back();
+	inNeighborLists.emplace_back();
+	outNeighborLists.emplace_back();
 	reverse.push_back(reverseNode);
 	nodeOffset.push_back(offset);
 	NodeChunkSequence normalSeq;
@@ -223,8 +234,8 @@ void AlignmentGraph::AddNode(int nodeId, int offset, const std::string& sequence
 		nodeSequences.emplace_back(normalSeq);
 	}
 	assert(nodeIDs.size() == nodeLength.size());
-	assert(nodeLength.size() == inNeighbors.size());
-	assert(inNeighbors.size() == outNeighbors.size());
+	assert(nodeLength.size() == inNeighborLists.size());
+	assert(inNeighborLists.size() == outNeighborLists.size());
 }
 
 void AlignmentGraph::AddEdgeNodeId(int node_id_from, int node_id_to, size_t startOffset)
@@ -245,36 +256,42 @@ void AlignmentGraph::AddEdgeNodeId(int node_id_from, int node_id_to, size_t star
 	}
 	assert(to != std::numeric_limits<size_t>::max());
 	//don't add double edges
-	if (std::find(inNeighbors[to].begin(), inNeighbors[to].end(), from) == inNeighbors[to].end()) inNeighbors[to].push_back(from);
-	if (std::find(outNeighbors[from].begin(), outNeighbors[from].end(), to) == outNeighbors[from].end()) outNeighbors[from].push_back(to);
+	if (std::find(inNeighborLists[to].begin(), inNeighborLists[to].end(), from) == inNeighborLists[to].end()) inNeighborLists[to].push_back(from);
+	if (std::find(outNeighborLists[from].begin(), outNeighborLists[from].end(), to) == outNeighborLists[from].end()) outNeighborLists[from].push_back(to);
 }
 
 void AlignmentGraph::Finalize(int wordSize)
 {
 	assert(nodeSequences.size() + ambiguousNodeSequences.size() == nodeLength.size());
-	assert(inNeighbors.size() == nodeLength.size());
-	assert(outNeighbors.size() == nodeLength.size());
+	assert(inNeighborLists.size() == nodeLength.size());
+	assert(outNeighborLists.size() == nodeLength.size());
 	assert(reverse.size() == nodeLength.size());
 	assert(nodeIDs.size() == nodeLength.size());
 	RenumberAmbiguousToEnd();
 	ambiguousNodes.clear();
+	if (nodeLength.size() > std::numeric_limits<uint32_t>::max()) throw CommonUtils::InvalidGraphException { "Graph has too many nodes" };
+	inNeighbors = NeighborList { inNeighborLists };
+	outNeighbors = NeighborList { outNeighborLists };
+	{
+		std::vector<std::vector<size_t>> tmp;
+		std::vector<std::vector<size_t>> tmp2;
+		std::swap(inNeighborLists, tmp);
+		std::swap(outNeighborLists, tmp2);
+	}
 	findLinearizable();
 	doComponentOrder();
 	findChains();
+	findComponentApproxPos();
 	std::cout << nodeLookup.size() << " original nodes" << std::endl;
 	std::cout << nodeLength.size() << " split nodes" << std::endl;
 	std::cout << ambiguousNodeSequences.size() << " ambiguous split nodes" << std::endl;
 	finalized = true;
 	int specialNodes = 0;
-	size_t edges = 0;
 	for (size_t i = 0; i < inNeighbors.size(); i++)
 	{
-		inNeighbors[i].shrink_to_fit();
-		outNeighbors[i].shrink_to_fit();
 		if (inNeighbors[i].size() >= 2) specialNodes++;
-		edges += inNeighbors[i].size();
 	}
-	std::cout << edges << " edges" << std::endl;
+	std::cout << inNeighbors.numEdges() << " edges" << std::endl;
 	std::cout << specialNodes << " nodes with in-degree >= 2" << std::endl;
 	assert(nodeSequences.size() + ambiguousNodeSequences.size() == nodeLength.size());
 	assert(inNeighbors.size() == nodeLength.size());
@@ -284,8 +301,6 @@ void AlignmentGraph::Finalize(int wordSize)
 	assert(nodeOffset.size() == nodeLength.size());
 	nodeLength.shrink_to_fit();
 	nodeIDs.shrink_to_fit();
-	inNeighbors.shrink_to_fit();
-	outNeighbors.shrink_to_fit();
 	reverse.shrink_to_fit();
 	nodeSequences.shrink_to_fit();
 	ambiguousNodeSequences.shrink_to_fit();
@@ -348,7 +363,8 @@ std::pair<bool, size_t> AlignmentGraph::findBubble(const size_t start, const std
 	return std::make_pair(false, 0);
 }
 
-size_t find(std::vector<size_t>& parent, size_t item)
+template <typename ParentArray>
+size_t find(ParentArray& parent, size_t item)
 {
 	if (parent[item] == item) return item;
 	std::vector<size_t> stack;
@@ -358,7 +374,8 @@ size_t find(std::vector<size_t>& parent, size_t item)
 	return stack.back();
 }
 
-void merge(std::vector<size_t>& parent, std::vector<size_t>& rank, size_t left, size_t right)
+template <typename ParentArray>
+void merge(ParentArray& parent, std::vector<size_t>& rank, size_t left, size_t right)
 {
 	left = find(parent, left);
 	right = find(parent, right);
@@ -634,6 +651,113 @@ void AlignmentGraph::findChains()
 	}
 }
 
+//approximate coordinates for chaining seeds across chains: the shortest distance from any source of the weakly connected component
+//sources are the nodes without in-neighbors, and one node of each cycle which can't be reached from the rest of the component
+//this is not a distance index. a tip which enters the middle of the component starts again from 0, so coordinates of
+//nodes on different paths can be far apart or in the wrong order, and seeds on them just won't be chained together
+void AlignmentGraph::findComponentApproxPos()
+{
+	connectedComponent.resize(nodeLength.size());
+	std::vector<size_t> rank;
+	rank.resize(nodeLength.size(), 0);
+	for (size_t i = 0; i < nodeLength.size(); i++)
+	{
+		connectedComponent[i] = i;
+	}
+	for (size_t i = 0; i < nodeLength.size(); i++)
+	{
+		for (auto neighbor : outNeighbors[i])
+		{
+			merge(connectedComponent, rank, i, neighbor);
+		}
+	}
+	{
+		std::vector<size_t> tmp;
+		std::swap(rank, tmp);
+	}
+	std::vector<size_t> componentIndex;
+	componentIndex.resize(nodeLength.size(), std::numeric_limits<size_t>::max());
+	size_t numComponents = 0;
+	for (size_t i = 0; i < nodeLength.size(); i++)
+	{
+		size_t root = find(connectedComponent, i);
+		if (componentIndex[root] == std::numeric_limits<size_t>::max())
+		{
+			componentIndex[root] = numComponents;
+			numComponents += 1;
+		}
+	}
+	for (size_t i = 0; i < nodeLength.size(); i++)
+	{
+		connectedComponent[i] = componentIndex[connectedComponent[i]];
+	}
+	{
+		std::vector<size_t> tmp;
+		std::swap(componentIndex, tmp);
+	}
+	//a strongly connected component is a source if no edge comes into it from another one
+	std::vector<bool> hasInEdge;
+	hasInEdge.resize(nodeLength.size(), false);
+	for (size_t i = 0; i < nodeLength.size(); i++)
+	{
+		for (auto neighbor : inNeighbors[i])
+		{
+			if (componentNumber[neighbor] != componentNumber[i]) hasInEdge[componentNumber[i]] = true;
+		}
+	}
+	std::vector<bool> sourceAdded;
+	sourceAdded.resize(nodeLength.size(), false);
+	componentApproxPos.resize(nodeLength.size(), std::numeric_limits<size_t>::max());
+	std::priority_queue<std::pair<size_t, size_t>, std::vector<std::pair<size_t, size_t>>, std::greater<std::pair<size_t, size_t>>> queue;
+	for (size_t i = 0; i < nodeLength.size(); i++)
+	{
+		if (hasInEdge[componentNumber[i]]) continue;
+		if (inNeighbors[i].size() > 0 && sourceAdded[componentNumber[i]]) continue;
+		sourceAdded[componentNumber[i]] = true;
+		queue.emplace(0, i);
+	}
+	{
+		std::vector<bool> tmp;
+		std::vector<bool> tmp2;
+		std::swap(hasInEdge, tmp);
+		std::swap(sourceAdded, tmp2);
+	}
+	while (queue.size() > 0)
+	{
+		auto top = queue.top();
+		queue.pop();
+		if (componentApproxPos[top.second] != std::numeric_limits<size_t>::max()) continue;
+		componentApproxPos[top.second] = top.first;
+		for (auto neighbor : outNeighbors[top.second])
+		{
+			if (componentApproxPos[neighbor] != std::numeric_limits<size_t>::max()) continue;
+			queue.emplace(top.first + nodeLength[top.second], neighbor);
+		}
+	}
+#ifndef NDEBUG
+	for (size_t i = 0; i < nodeLength.size(); i++)
+	{
+		assert(componentApproxPos[i] != std::numeric_limits<size_t>::max());
+	}
+#endif
+}
+
+bool AlignmentGraph::MaybeReachable(size_t fromNode, size_t toNode) const
+{
+	//strongly connected components are numbered in topological order
+	return connectedComponent[fromNode] == connectedComponent[toNode] && componentNumber[fromNode] <= componentNumber[toNode];
+}
+
+size_t AlignmentGraph::ConnectedComponent(size_t node) const
+{
+	return connectedComponent[node];
+}
+
+size_t AlignmentGraph::ApproxPosition(size_t node, size_t offset) const
+{
+	return componentApproxPos[node] + offset;
+}
+
 void AlignmentGraph::findLinearizable()
 {
 	linearizable.resize(nodeLength.size(), false);
@@ -888,11 +1012,11 @@ std::vector<size_t> renumber(const std::vector<size_t>& vec, const std::vector<s
 	return result;
 }
 
-template <typename T>
-std::vector<T> reorder(const std::vector<T>& vec, const std::vector<size_t>& renumbering)
+template <typename Array>
+std::vector<typename Array::value_type> reorder(const Array& vec, const std::vector<size_t>& renumbering)
 {
 	assert(vec.size() == renumbering.size());
-	std::vector<T> result;
+	std::vector<typename Array::value_type> result;
 	result.resize(vec.size());
 	for (size_t i = 0; i < vec.size(); i++)
 	{
@@ -904,8 +1028,8 @@ std::vector<T> reorder(const std::vector<T>& vec, const std::vector<size_t>& ren
 void AlignmentGraph::RenumberAmbiguousToEnd()
 {
 	assert(nodeSequences.size() + ambiguousNodeSequences.size() == nodeLength.size());
-	assert(inNeighbors.size() == nodeLength.size());
-	assert(outNeighbors.size() == nodeLength.size());
+	assert(inNeighborLists.size() == nodeLength.size());
+	assert(outNeighborLists.size() == nodeLength.size());
 	assert(reverse.size() == nodeLength.size());
 	assert(nodeIDs.size() == nodeLength.size());
 	assert(ambiguousNodes.size() == nodeLength.size());
@@ -944,31 +1068,31 @@ void AlignmentGraph::RenumberAmbiguousToEnd()
 	nodeLength = reorder(nodeLength, renumbering);
 	nodeOffset = reorder(nodeOffset, renumbering);
 	nodeIDs = reorder(nodeIDs, renumbering);
-	inNeighbors = reorder(inNeighbors, renumbering);
-	outNeighbors = reorder(outNeighbors, renumbering);
+	inNeighborLists = reorder(inNeighborLists, renumbering);
+	outNeighborLists = reorder(outNeighborLists, renumbering);
 	reverse = reorder(reverse, renumbering);
 	for (auto& pair : nodeLookup)
 	{
 		pair.second = renumber(pair.second, renumbering);
 	}
-	assert(inNeighbors.size() == outNeighbors.size());
-	for (size_t i = 0; i < inNeighbors.size(); i++)
+	assert(inNeighborLists.size() == outNeighborLists.size());
+	for (size_t i = 0; i < inNeighborLists.size(); i++)
 	{
-		inNeighbors[i] = renumber(inNeighbors[i], renumbering);
-		outNeighbors[i] = renumber(outNeighbors[i], renumbering);
+		inNeighborLists[i] = renumber(inNeighborLists[i], renumbering);
+		outNeighborLists[i] = renumber(outNeighborLists[i], renumbering);
 	}
 
 #ifndef NDEBUG
-	assert(inNeighbors.size() == outNeighbors.size());
-	for (size_t i = 0; i < inNeighbors.size(); i++)
+	assert(inNeighborLists.size() == outNeighborLists.size());
+	for (size_t i = 0; i < inNeighborLists.size(); i++)
 	{
-		for (auto neighbor : inNeighbors[i])
+		for (auto neighbor : inNeighborLists[i])
 		{
-			assert(std::find(outNeighbors[neighbor].begin(), outNeighbors[neighbor].end(), i) != outNeighbors[neighbor].end());
+			assert(std::find(outNeighborLists[neighbor].begin(), outNeighborLists[neighbor].end(), i) != outNeighborLists[neighbor].end());
 		}
-		for (auto neighbor : outNeighbors[i])
+		for (auto neighbor : outNeighborLists[i])
 		{
-			assert(std::find(inNeighbors[neighbor].begin(), inNeighbors[neighbor].end(), i) != inNeighbors[neighbor].end());
+			assert(std::find(inNeighborLists[neighbor].begin(), inNeighborLists[neighbor].end(), i) != inNeighborLists[neighbor].end());
 		}
 	}
 	for (auto pair : nodeLookup)
@@ -990,6 +1114,59 @@ void AlignmentGraph::RenumberAmbiguousToEnd()
 #endif
 }
 
+void AlignmentGraph::RenumberForLocality()
+{
+	assert(finalized);
+	std::vector<size_t> order;
+	order.reserve(nodeLength.size());
+	for (size_t i = 0; i < nodeLength.size(); i++)
+	{
+		order.push_back(i);
+	}
+	//ambiguous nodes stay at the end since their sequences are stored separately
+	std::sort(order.begin(), order.end(), [this](size_t left, size_t right)
+	{
+		return std::make_tuple(left >= firstAmbiguous, componentNumber[left], chainNumber[left], chainApproxPos[left], left) < std::make_tuple(right >= firstAmbiguous, componentNumber[right], chainNumber[right], chainApproxPos[right], right);
+	});
+	std::vector<size_t> renumbering;
+	renumbering.resize(order.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		renumbering[order[i]] = i;
+	}
+	{
+		std::vector<size_t> tmp;
+		std::swap(order, tmp);
+	}
+	std::vector<size_t> nonAmbiguousRenumbering { renumbering.begin(), renumbering.begin() + firstAmbiguous };
+	std::vector<size_t> ambiguousRenumbering;
+	ambiguousRenumbering.reserve(renumbering.size() - firstAmbiguous);
+	for (size_t i = firstAmbiguous; i < renumbering.size(); i++)
+	{
+		assert(renumbering[i] >= firstAmbiguous);
+		ambiguousRenumbering.push_back(renumbering[i] - firstAmbiguous);
+	}
+	nodeSequences = reorder(nodeSequences, nonAmbiguousRenumbering);
+	ambiguousNodeSequences = reorder(ambiguousNodeSequences, ambiguousRenumbering);
+	nodeLength = reorder(nodeLength, renumbering);
+	nodeOffset = reorder(nodeOffset, renumbering);
+	nodeIDs = reorder(nodeIDs, renumbering);
+	reverse = reorder(reverse, renumbering);
+	linearizable = reorder(linearizable, renumbering);
+	componentNumber = reorder(componentNumber, renumbering);
+	chainApproxPos = reorder(chainApproxPos, renumbering);
+	connectedComponent = reorder(connectedComponent, renumbering);
+	componentApproxPos = reorder(componentApproxPos, renumbering);
+	//chain numbers are the index of a node in the chain
+	chainNumber = renumber(reorder(chainNumber, renumbering), renumbering);
+	inNeighbors = inNeighbors.Renumber(renumbering);
+	outNeighbors = outNeighbors.Renumber(renumbering);
+	for (auto& pair : nodeLookup)
+	{
+		pair.second = renumber(pair.second, renumbering);
+	}
+}
+
 void AlignmentGraph::doComponentOrder()
 {
 	std::vector<std::tuple<size_t, int, size_t>> callStack;
@@ -1107,4 +1284,308 @@ size_t AlignmentGraph::ComponentSize() const
 size_t AlignmentGraph::SizeInBP() const
 {
 	return bpSize;
-}
\ No newline at end of file
+}
+
+//binary graph file: magic, version, layout constants, the description of the input it was built from, then every member as a length-prefixed flat array
+//all arrays are padded to 8 bytes so the file can be mmapped and read without unaligned accesses
+constexpr uint64_t GraphFileMagic = 0x4850524741544C41; //"ALTAGRPH"
+constexpr uint64_t GraphFileVersion = 4;
+
+class GraphFileWriter
+{
+public:
+	GraphFileWriter(const std::string& filename) :
+	file(filename, std::ios::binary)
+	{
+	}
+	bool close()
+	{
+		file.close();
+		return !file.fail();
+	}
+	void writeInt(uint64_t value)
+	{
+		file.write((const char*)&value, sizeof(uint64_t));
+	}
+	template <typename T>
+	void writeArray(const T* data, size_t count)
+	{
+		static_assert(std::is_trivially_copyable<T>::value);
+		writeInt(count);
+		file.write((const char*)data, sizeof(T) * count);
+		size_t padding = (8 - (sizeof(T) * count) % 8) % 8;
+		char zeros[8] {0, 0, 0, 0, 0, 0, 0, 0};
+		file.write(zeros, padding);
+	}
+	template <typename Array>
+	void writeVector(const Array& vec)
+	{
+		writeArray(vec.data(), vec.size());
+	}
+	void writeString(const std::string& str)
+	{
+		writeArray(str.data(), str.size());
+	}
+private:
+	std::ofstream file;
+};
+
+class GraphFileReader
+{
+public:
+	GraphFileReader(const std::string& filename) :
+	filename(filename),
+	fd(-1),
+	data(nullptr),
+	size(0),
+	pos(0)
+	{
+		fd = open(filename.c_str(), O_RDONLY);
+		if (fd == -1) throw CommonUtils::InvalidGraphException("Could not open graph file " + filename);
+		struct stat fileStat;
+		if (fstat(fd, &fileStat) == -1)
+		{
+			close(fd);
+			throw CommonUtils::InvalidGraphException("Could not read graph file " + filename);
+		}
+		size = fileStat.st_size;
+		if (size == 0)
+		{
+			close(fd);
+			throw CommonUtils::InvalidGraphException("Graph file " + filename + " is empty");
+		}
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+		if (mapped == MAP_FAILED)
+		{
+			close(fd);
+			throw CommonUtils::InvalidGraphException("Could not mmap graph file " + filename);
+		}
+		data = (const char*)mapped;
+		//the loaded graph keeps views into the mapping and reads it in alignment order, not sequentially
+		madvise(mapped, size, MADV_WILLNEED);
+	}
+	~GraphFileReader()
+	{
+		if (data != nullptr) munmap((void*)data, size);
+		if (fd != -1) close(fd);
+	}
+	GraphFileReader(const GraphFileReader& other) = delete;
+	GraphFileReader& operator=(const GraphFileReader& other) = delete;
+	uint64_t readInt()
+	{
+		checkRemaining(sizeof(uint64_t));
+		uint64_t result;
+		memcpy(&result, data + pos, sizeof(uint64_t));
+		pos += sizeof(uint64_t);
+		return result;
+	}
+	template <typename T>
+	const T* readArray(size_t& count)
+	{
+		static_assert(std::is_trivially_copyable<T>::value);
+		count = readInt();
+		if (count > (size - pos) / sizeof(T)) throw CommonUtils::InvalidGraphException("Graph file " + filename + " is truncated");
+		const T* result = (const T*)(data + pos);
+		size_t bytes = sizeof(T) * count;
+		bytes += (8 - bytes % 8) % 8;
+		checkRemaining(bytes);
+		pos += bytes;
+		return result;
+	}
+	template <typename T>
+	void readVector(std::vector<T>& vec)
+	{
+		size_t count;
+		const T* arr = readArray<T>(count);
+		vec.assign(arr, arr + count);
+	}
+	//the view is valid as long as the reader is
+	template <typename T>
+	void readView(MappedArray<T>& arr)
+	{
+		size_t count;
+		const T* first = readArray<T>(count);
+		arr = MappedArray<T>::View(first, count);
+	}
+	std::string readString()
+	{
+		size_t count;
+		const char* arr = readArray<char>(count);
+		return std::string { arr, arr + count };
+	}
+	bool atEnd() const
+	{
+		return pos == size;
+	}
+private:
+	void checkRemaining(size_t bytes) const
+	{
+		if (size - pos < bytes) throw CommonUtils::InvalidGraphException("Graph file " + filename + " is truncated");
+	}
+	std::string filename;
+	int fd;
+	const char* data;
+	size_t size;
+	size_t pos;
+};
+
+//writes to a temporary file which is renamed over filename when complete, so a crashed or concurrent run never leaves a partial file behind
+void AlignmentGraph::SaveToFile(const std::string& filename, const std::string& source) const
+{
+	assert(finalized);
+	std::string tmpFile = filename + ".tmp" + std::to_string(getpid());
+	GraphFileWriter writer { tmpFile };
+	writer.writeInt(GraphFileMagic);
+	writer.writeInt(GraphFileVersion);
+	writer.writeInt(SPLIT_NODE_SIZE);
+	writer.writeInt(BP_IN_CHUNK);
+	writer.writeString(source);
+	writer.writeInt(bpSize);
+	writer.writeInt(firstAmbiguous);
+	writer.writeInt(DBGoverlap);
+	writer.writeVector(nodeLength);
+	writer.writeVector(nodeOffset);
+	writer.writeVector(nodeIDs);
+	writer.writeVector(reverse);
+	writer.writeVector(linearizable);
+	writer.writeVector(nodeSequences);
+	writer.writeVector(ambiguousNodeSequences);
+	writer.writeVector(componentNumber);
+	writer.writeVector(chainNumber);
+	writer.writeVector(chainApproxPos);
+	writer.writeVector(connectedComponent);
+	writer.writeVector(componentApproxPos);
+	writer.writeVector(inNeighbors.start);
+	writer.writeVector(inNeighbors.targets);
+	writer.writeVector(outNeighbors.start);
+	writer.writeVector(outNeighbors.targets);
+	//nodeLookup is recreated from nodeIDs and nodeOffset when loading
+	std::vector<int> originalIds;
+	std::vector<size_t> originalSizes;
+	originalIds.reserve(originalNodeSize.size());
+	originalSizes.reserve(originalNodeSize.size());
+	for (auto pair : originalNodeSize)
+	{
+		originalIds.push_back(pair.first);
+		originalSizes.push_back(pair.second);
+	}
+	writer.writeVector(originalIds);
+	writer.writeVector(originalSizes);
+	writer.writeInt(originalNodeName.size());
+	for (const auto& pair : originalNodeName)
+	{
+		writer.writeInt(pair.first);
+		writer.writeString(pair.second);
+	}
+	if (!writer.close())
+	{
+		std::cerr << "Could not write graph file " << filename << std::endl;
+		std::remove(tmpFile.c_str());
+		return;
+	}
+	if (std::rename(tmpFile.c_str(), filename.c_str()) != 0)
+	{
+		std::cerr << "Could not write graph file " << filename << std::endl;
+		std::remove(tmpFile.c_str());
+	}
+}
+
+bool AlignmentGraph::FileMatchesSource(const std::string& filename, const std::string& source)
+{
+	try
+	{
+		GraphFileReader reader { filename };
+		if (reader.readInt() != GraphFileMagic) return false;
+		if (reader.readInt() != GraphFileVersion) return false;
+		if (reader.readInt() != SPLIT_NODE_SIZE) return false;
+		if (reader.readInt() != BP_IN_CHUNK) return false;
+		return reader.readString() == source;
+	}
+	catch (const CommonUtils::InvalidGraphException& e)
+	{
+		return false;
+	}
+}
+
+AlignmentGraph AlignmentGraph::LoadFromFile(const std::string& filename)
+{
+	auto reader = std::make_shared<GraphFileReader>(filename);
+	if (reader->readInt() != GraphFileMagic) throw CommonUtils::InvalidGraphException("File " + filename + " is not a GraphAligner graph file");
+	if (reader->readInt() != GraphFileVersion) throw CommonUtils::InvalidGraphException("Graph file " + filename + " was written by an incompatible version of GraphAligner");
+	if (reader->readInt() != SPLIT_NODE_SIZE) throw CommonUtils::InvalidGraphException("Graph file " + filename + " has a different split node size");
+	if (reader->readInt() != BP_IN_CHUNK) throw CommonUtils::InvalidGraphException("Graph file " + filename + " has a different chunk size");
+	reader->readString();
+	AlignmentGraph result;
+	result.bpSize = reader->readInt();
+	result.firstAmbiguous = reader->readInt();
+	result.DBGoverlap = reader->readInt();
+	reader->readView(result.nodeLength);
+	reader->readView(result.nodeOffset);
+	reader->readView(result.nodeIDs);
+	reader->readView(result.reverse);
+	reader->readView(result.linearizable);
+	reader->readView(result.nodeSequences);
+	reader->readView(result.ambiguousNodeSequences);
+	reader->readView(result.componentNumber);
+	reader->readView(result.chainNumber);
+	reader->readView(result.chainApproxPos);
+	reader->readView(result.connectedComponent);
+	reader->readView(result.componentApproxPos);
+	size_t nodeCount = result.nodeLength.size();
+	for (size_t size : { result.nodeOffset.size(), result.nodeIDs.size(), result.reverse.size(), result.linearizable.size(), result.nodeSequences.size() + result.ambiguousNodeSequences.size(), result.componentNumber.size(), result.chainNumber.size(), result.chainApproxPos.size(), result.connectedComponent.size(), result.componentApproxPos.size() })
+	{
+		if (size != nodeCount) throw CommonUtils::InvalidGraphException("Graph file " + filename + " is corrupted");
+	}
+	if (result.nodeSequences.size() != result.firstAmbiguous) throw CommonUtils::InvalidGraphException("Graph file " + filename + " is corrupted");
+	for (auto neighbors : { &result.inNeighbors, &result.outNeighbors })
+	{
+		reader->readView(neighbors->start);
+		reader->readView(neighbors->targets);
+		//the arrays are views into the mapping, only read them through const references so they aren't copied
+		const NeighborList& list = *neighbors;
+		if (list.start.size() != nodeCount + 1 || list.start[0] != 0 || list.start[nodeCount] != list.targets.size()) throw CommonUtils::InvalidGraphException("Graph file " + filename + " is corrupted");
+		for (size_t i = 0; i < nodeCount; i++)
+		{
+			if (list.start[i] > list.start[i+1]) throw CommonUtils::InvalidGraphException("Graph file " + filename + " is corrupted");
+		}
+		for (auto target : list.targets)
+		{
+			if (target >= nodeCount) throw CommonUtils::InvalidGraphException("Graph file " + filename + " is corrupted");
+		}
+	}
+	std::vector<int> originalIds;
+	std::vector<size_t> originalSizes;
+	reader->readVector(originalIds);
+	reader->readVector(originalSizes);
+	if (originalIds.size() != originalSizes.size()) throw CommonUtils::InvalidGraphException("Graph file " + filename + " is corrupted");
+	result.originalNodeSize.reserve(originalIds.size());
+	for (size_t i = 0; i < originalIds.size(); i++)
+	{
+		result.originalNodeSize[originalIds[i]] = originalSizes[i];
+	}
+	size_t nameCount = reader->readInt();
+	result.originalNodeName.reserve(nameCount);
+	for (size_t i = 0; i < nameCount; i++)
+	{
+		int nodeId = (int)reader->readInt();
+		result.originalNodeName[nodeId] = reader->readString();
+	}
+	if (!reader->atEnd()) throw CommonUtils::InvalidGraphException("Graph file " + filename + " is corrupted");
+	const auto& nodeIDs = result.nodeIDs;
+	const auto& nodeOffset = result.nodeOffset;
+	result.nodeLookup.reserve(result.originalNodeSize.size());
+	for (size_t i = 0; i < nodeCount; i++)
+	{
+		result.nodeLookup[nodeIDs[i]].push_back(i);
+	}
+	for (auto& pair : result.nodeLookup)
+	{
+		std::sort(pair.second.begin(), pair.second.end(), [&nodeOffset](size_t left, size_t right) { return nodeOffset[left] < nodeOffset[right]; });
+	}
+	result.fileMapping = reader;
+	result.finalized = true;
+	std::cout << result.nodeLookup.size() << " original nodes" << std::endl;
+	std::cout << result.nodeLength.size() << " split nodes" << std::endl;
+	std::cout << result.ambiguousNodeSequences.size() << " ambiguous split nodes" << std::endl;
+	return result;
+}
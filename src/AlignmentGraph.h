@@ -1,7 +1,9 @@
 #ifndef AlignmentGraph_h
 #define AlignmentGraph_h
 
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <vector>
 #include <set>
 #include <unordered_map>
@@ -10,6 +12,292 @@
 #include <phmap.h>
 #include "ThreadReadAssertion.h"
 
+//an array which either owns its elements or is a read-only view into a mapped graph file
+//the graph keeps the mapping alive as long as it has views into it. modifying a view copies it first
+template <typename T>
+class MappedArray
+{
+public:
+	typedef T value_type;
+	MappedArray() :
+	owned(),
+	first(nullptr),
+	count(0),
+	view(false)
+	{
+	}
+	MappedArray(std::vector<T>&& vec) :
+	owned(std::move(vec)),
+	first(owned.data()),
+	count(owned.size()),
+	view(false)
+	{
+	}
+	MappedArray(const MappedArray& other) :
+	owned(other.owned),
+	first(other.view ? other.first : owned.data()),
+	count(other.count),
+	view(other.view)
+	{
+	}
+	MappedArray(MappedArray&& other) :
+	owned(std::move(other.owned)),
+	first(other.view ? other.first : owned.data()),
+	count(other.count),
+	view(other.view)
+	{
+		other.clear();
+	}
+	MappedArray& operator=(const MappedArray& other)
+	{
+		owned = other.owned;
+		first = other.view ? other.first : owned.data();
+		count = other.count;
+		view = other.view;
+		return *this;
+	}
+	MappedArray& operator=(MappedArray&& other)
+	{
+		owned = std::move(other.owned);
+		first = other.view ? other.first : owned.data();
+		count = other.count;
+		view = other.view;
+		other.clear();
+		return *this;
+	}
+	MappedArray& operator=(std::vector<T>&& vec)
+	{
+		owned = std::move(vec);
+		view = false;
+		sync();
+		return *this;
+	}
+	static MappedArray View(const T* first, size_t count)
+	{
+		MappedArray result;
+		result.first = first;
+		result.count = count;
+		result.view = true;
+		return result;
+	}
+#ifdef NDEBUG
+	__attribute__((always_inline))
+#endif
+	const T& operator[](size_t index) const
+	{
+		assert(index < count);
+		return first[index];
+	}
+	T& operator[](size_t index)
+	{
+		makeOwned();
+		assert(index < count);
+		return owned[index];
+	}
+	size_t size() const
+	{
+		return count;
+	}
+	bool empty() const
+	{
+		return count == 0;
+	}
+	const T* data() const
+	{
+		return first;
+	}
+	const T* begin() const
+	{
+		return first;
+	}
+	const T* end() const
+	{
+		return first + count;
+	}
+	T* begin()
+	{
+		makeOwned();
+		return owned.data();
+	}
+	T* end()
+	{
+		makeOwned();
+		return owned.data() + count;
+	}
+	const T& back() const
+	{
+		assert(count > 0);
+		return first[count-1];
+	}
+	template <typename... Args>
+	void push_back(Args&&... args)
+	{
+		makeOwned();
+		owned.push_back(std::forward<Args>(args)...);
+		sync();
+	}
+	template <typename... Args>
+	void emplace_back(Args&&... args)
+	{
+		makeOwned();
+		owned.emplace_back(std::forward<Args>(args)...);
+		sync();
+	}
+	void reserve(size_t size)
+	{
+		makeOwned();
+		owned.reserve(size);
+		sync();
+	}
+	template <typename... Args>
+	void resize(Args&&... args)
+	{
+		makeOwned();
+		owned.resize(std::forward<Args>(args)...);
+		sync();
+	}
+	template <typename... Args>
+	void assign(Args&&... args)
+	{
+		makeOwned();
+		owned.assign(std::forward<Args>(args)...);
+		sync();
+	}
+	void shrink_to_fit()
+	{
+		if (view) return;
+		owned.shrink_to_fit();
+		sync();
+	}
+	void clear()
+	{
+		owned.clear();
+		view = false;
+		sync();
+	}
+private:
+	void makeOwned()
+	{
+		if (!view) return;
+		owned.assign(first, first + count);
+		view = false;
+		sync();
+	}
+	void sync()
+	{
+		first = owned.data();
+		count = owned.size();
+	}
+	std::vector<T> owned;
+	const T* first;
+	size_t count;
+	bool view;
+};
+
+//compressed sparse row adjacency lists, neighbors of node i are targets[start[i]] .. targets[start[i+1]-1]
+//one allocation for the whole graph instead of one per node, and neighbors of consecutive nodes are next to each other
+class NeighborList
+{
+public:
+	class Range
+	{
+	public:
+		Range(const uint32_t* first, const uint32_t* last) :
+		first(first),
+		last(last)
+		{
+		}
+		const uint32_t* begin() const
+		{
+			return first;
+		}
+		const uint32_t* end() const
+		{
+			return last;
+		}
+		size_t size() const
+		{
+			return last - first;
+		}
+		size_t operator[](size_t index) const
+		{
+			assert(index < size());
+			return first[index];
+		}
+	private:
+		const uint32_t* first;
+		const uint32_t* last;
+	};
+	NeighborList() :
+	start(std::vector<uint64_t>(1, 0)),
+	targets()
+	{
+	}
+	NeighborList(const std::vector<std::vector<size_t>>& lists) :
+	start(),
+	targets()
+	{
+		std::vector<uint64_t> newStart;
+		std::vector<uint32_t> newTargets;
+		newStart.reserve(lists.size()+1);
+		newStart.push_back(0);
+		for (const auto& list : lists)
+		{
+			newStart.push_back(newStart.back() + list.size());
+		}
+		newTargets.reserve(newStart.back());
+		for (const auto& list : lists)
+		{
+			newTargets.insert(newTargets.end(), list.begin(), list.end());
+		}
+		start = std::move(newStart);
+		targets = std::move(newTargets);
+	}
+#ifdef NDEBUG
+	__attribute__((always_inline))
+#endif
+	Range operator[](size_t node) const
+	{
+		assert(node+1 < start.size());
+		return Range { targets.data() + start[node], targets.data() + start[node+1] };
+	}
+	size_t size() const
+	{
+		return start.size()-1;
+	}
+	size_t numEdges() const
+	{
+		return targets.size();
+	}
+	//node i becomes node renumbering[i]
+	NeighborList Renumber(const std::vector<size_t>& renumbering) const
+	{
+		assert(renumbering.size() == size());
+		NeighborList result;
+		result.start.assign(size()+1, 0);
+		for (size_t i = 0; i < size(); i++)
+		{
+			result.start[renumbering[i]+1] = start[i+1] - start[i];
+		}
+		for (size_t i = 1; i < result.start.size(); i++)
+		{
+			result.start[i] += result.start[i-1];
+		}
+		result.targets.resize(targets.size());
+		for (size_t i = 0; i < size(); i++)
+		{
+			size_t pos = result.start[renumbering[i]];
+			for (size_t j = start[i]; j < start[i+1]; j++)
+			{
+				result.targets[pos] = renumbering[targets[j]];
+				pos += 1;
+			}
+		}
+		return result;
+	}
+	MappedArray<uint64_t> start;
+	MappedArray<uint32_t> targets;
+};
 
 class AlignmentGraph
 {
@@ -90,6 +378,8 @@ public:
 	void AddNode(int nodeId, const std::string& sequence, const std::string& name, bool reverseNode, const std::vector<size_t>& breakpoints);
 	void AddEdgeNodeId(int node_id_from, int node_id_to, size_t startOffset);
 	void Finalize(int wordSize);
+	//renumber the nodes by component, chain and position in the chain so nodes which are aligned together are close in memory
+	void RenumberForLocality();
 	AlignmentGraph GetSubgraph(const std::unordered_map<size_t, size_t>& nodeMapping) const;
 	std::pair<int, size_t> GetReversePosition(int nodeId, size_t offset) const;
 	size_t GetReverseNode(size_t node) const;
@@ -100,12 +390,21 @@ public:
 	NodeChunkSequence NodeChunks(size_t node) const;
 	AmbiguousChunkSequence AmbiguousNodeChunks(size_t node) const;
 	size_t GetUnitigNode(int nodeId, size_t offset) const;
+	//false if there is certainly no path from one node to the other
+	bool MaybeReachable(size_t fromNode, size_t toNode) const;
+	size_t ConnectedComponent(size_t node) const;
+	//rough coordinate for seed chaining, only comparable within one connected component and not a distance
+	size_t ApproxPosition(size_t node, size_t offset) const;
 	// size_t MinDistance(size_t pos, const std::vector<size_t>& targets) const;
 	// std::set<size_t> ProjectForward(const std::set<size_t>& startpositions, size_t amount) const;
 	std::string OriginalNodeName(int nodeId) const;
 	size_t ComponentSize() const;
 	static AlignmentGraph DummyGraph();
 	size_t getDBGoverlap() const;
+	//source describes the input the graph was built from, a cache is only reused if it's the same
+	void SaveToFile(const std::string& filename, const std::string& source) const;
+	static AlignmentGraph LoadFromFile(const std::string& filename);
+	static bool FileMatchesSource(const std::string& filename, const std::string& source);
 
 private:
 	void fixChainApproxPos(const size_t start);
@@ -114,30 +413,39 @@ private:
 	phmap::flat_hash_map<size_t, std::unordered_set<size_t>> chainTips(std::vector<size_t>& rank, std::vector<bool>& ignorableTip);
 	void chainCycles(std::vector<size_t>& rank, std::vector<bool>& ignorableTip);
 	void findChains();
+	void findComponentApproxPos();
 	void findLinearizable();
 	void AddNode(int nodeId, int offset, const std::string& sequence, bool reverseNode);
 	void RenumberAmbiguousToEnd();
 	void doComponentOrder();
-	std::vector<size_t> nodeLength;
+	MappedArray<size_t> nodeLength;
 	std::unordered_map<int, std::vector<size_t>> nodeLookup;
 	std::unordered_map<int, size_t> originalNodeSize;
 	std::unordered_map<int, std::string> originalNodeName;
-	std::vector<size_t> nodeOffset;
-	std::vector<int> nodeIDs;
-	std::vector<std::vector<size_t>> inNeighbors;
-	std::vector<std::vector<size_t>> outNeighbors;
-	std::vector<bool> reverse;
-	std::vector<bool> linearizable;
-	std::vector<NodeChunkSequence> nodeSequences;
+	MappedArray<size_t> nodeOffset;
+	MappedArray<int> nodeIDs;
+	//adjacency while the graph is being built, moved into the CSR lists in Finalize
+	std::vector<std::vector<size_t>> inNeighborLists;
+	std::vector<std::vector<size_t>> outNeighborLists;
+	NeighborList inNeighbors;
+	NeighborList outNeighbors;
+	MappedArray<uint8_t> reverse;
+	MappedArray<uint8_t> linearizable;
+	MappedArray<NodeChunkSequence> nodeSequences;
 	size_t bpSize;
-	std::vector<AmbiguousChunkSequence> ambiguousNodeSequences;
+	MappedArray<AmbiguousChunkSequence> ambiguousNodeSequences;
 	std::vector<bool> ambiguousNodes;
-	std::vector<size_t> componentNumber;
-	std::vector<size_t> chainNumber;
-	std::vector<size_t> chainApproxPos;
+	MappedArray<size_t> componentNumber;
+	MappedArray<size_t> chainNumber;
+	MappedArray<size_t> chainApproxPos;
+	//weakly connected component, and the shortest distance to the start of the node from the nodes without in-neighbors
+	MappedArray<size_t> connectedComponent;
+	MappedArray<size_t> componentApproxPos;
 	size_t firstAmbiguous;
 	size_t DBGoverlap;
 	bool finalized;
+	//the graph file when the arrays are views into it
+	std::shared_ptr<const void> fileMapping;
 
 	template <typename LengthType, typename ScoreType, typename Word>
 	friend class GraphAligner;
@@ -153,6 +461,7 @@ private:
 	friend class GraphAlignerBitvectorDijkstra;
 	friend class DirectedGraph;
 	friend class MinimizerSeeder;
+	friend class SeedHeuristic;
 };
 
 
@@ -1,6 +1,11 @@
 #include <fstream>
 #include <sstream>
 #include <cassert>
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <atomic>
+#include <thread>
 #include <unordered_map>
 #include "CommonUtils.h"
 #include "vg.pb.h"
@@ -265,3 +270,361 @@ AlignmentGraph DirectedGraph::BuildFromGFA(const GfaGraph& graph)
 	result.Finalize(64);
 	return result;
 }
+
+//S and L records of one chunk of a GFA file
+//the edge endpoints are kept as names until all S lines have been read, and then translated to node ids in parallel
+class GfaChunk
+{
+public:
+	struct Edge
+	{
+		//offsets of the names in edgeNames
+		size_t fromName;
+		bool fromEnd;
+		size_t toName;
+		bool toEnd;
+		size_t overlap;
+	};
+	void clear()
+	{
+		nodeNames.clear();
+		sequence.clear();
+		nodeSequenceEnd.clear();
+		edgeNames.clear();
+		edges.clear();
+		error.clear();
+	}
+	std::vector<std::string> nodeNames;
+	std::string sequence;
+	std::vector<size_t> nodeSequenceEnd;
+	//endpoint names of the edges, each followed by a 0
+	std::string edgeNames;
+	std::vector<Edge> edges;
+	std::string error;
+};
+
+//splits the line [start, end) at tabs or spaces
+static std::vector<std::pair<size_t, size_t>> splitGfaLine(const std::string& block, size_t start, size_t end)
+{
+	std::vector<std::pair<size_t, size_t>> result;
+	size_t fieldStart = start;
+	for (size_t i = start; i <= end; i++)
+	{
+		if (i == end || block[i] == '\t' || block[i] == ' ')
+		{
+			if (i > fieldStart) result.emplace_back(fieldStart, i);
+			fieldStart = i+1;
+		}
+	}
+	return result;
+}
+
+static void parseGfaLine(const std::string& block, size_t start, size_t end, GfaChunk& result)
+{
+	auto fields = splitGfaLine(block, start, end);
+	if (fields.size() == 0 || fields[0].second - fields[0].first != 1) return;
+	auto fieldString = [&block, &fields](size_t i) { return block.substr(fields[i].first, fields[i].second - fields[i].first); };
+	if (block[start] == 'S')
+	{
+		if (fields.size() < 3) throw CommonUtils::InvalidGraphException { "Node line has too few fields: " + block.substr(start, end - start) };
+		std::string name = fieldString(1);
+		if (fields[2].second - fields[2].first == 1 && block[fields[2].first] == '*') throw CommonUtils::InvalidGraphException { std::string { "Nodes without sequence (*) are not currently supported (nodeid " + name + ")" } };
+		for (size_t i = fields[2].first; i < fields[2].second; i++)
+		{
+			if (!allowed[(unsigned char)block[i]])
+			{
+				throw CommonUtils::InvalidGraphException { "Invalid sequence character: " + std::string { block[i] } };
+			}
+		}
+		result.nodeNames.push_back(std::move(name));
+		result.sequence.append(block, fields[2].first, fields[2].second - fields[2].first);
+		result.nodeSequenceEnd.push_back(result.sequence.size());
+	}
+	else if (block[start] == 'L')
+	{
+		if (fields.size() < 6) throw CommonUtils::InvalidGraphException { "Edge line has too few fields: " + block.substr(start, end - start) };
+		std::string fromstart = fieldString(2);
+		std::string toend = fieldString(4);
+		if ((fromstart != "+" && fromstart != "-") || (toend != "+" && toend != "-")) throw CommonUtils::InvalidGraphException { "Edge orientation must be + or -: " + block.substr(start, end - start) };
+		if (block[fields[5].first] == '-') throw CommonUtils::InvalidGraphException { "Edge overlap cannot be negative. Fix the graph" };
+		char* overlapEnd;
+		size_t overlap = strtoull(block.c_str() + fields[5].first, &overlapEnd, 10);
+		size_t overlapEndPos = overlapEnd - block.c_str();
+		if (overlapEndPos == fields[5].first || overlapEndPos + 1 != fields[5].second || (block[overlapEndPos] != 'M' && !(block[overlapEndPos] == 'S' && overlap == 0)))
+		{
+			throw CommonUtils::InvalidGraphException { "Edge overlap must be a number of matches (eg. 0M): " + block.substr(start, end - start) };
+		}
+		GfaChunk::Edge edge;
+		edge.fromName = result.edgeNames.size();
+		result.edgeNames.append(block, fields[1].first, fields[1].second - fields[1].first);
+		result.edgeNames.push_back(0);
+		edge.fromEnd = fromstart == "+";
+		edge.toName = result.edgeNames.size();
+		result.edgeNames.append(block, fields[3].first, fields[3].second - fields[3].first);
+		result.edgeNames.push_back(0);
+		edge.toEnd = toend == "+";
+		edge.overlap = overlap;
+		result.edges.push_back(edge);
+	}
+}
+
+static void parseGfaChunk(const std::string& block, GfaChunk& result)
+{
+	result.clear();
+	try
+	{
+		size_t lineStart = 0;
+		while (lineStart < block.size())
+		{
+			size_t lineEnd = block.find('\n', lineStart);
+			if (lineEnd == std::string::npos) lineEnd = block.size();
+			size_t end = lineEnd;
+			if (end > lineStart && block[end-1] == '\r') end -= 1;
+			if (end > lineStart && (block[lineStart] == 'S' || block[lineStart] == 'L')) parseGfaLine(block, lineStart, end, result);
+			lineStart = lineEnd + 1;
+		}
+	}
+	catch (const CommonUtils::InvalidGraphException& e)
+	{
+		result.error = e.what();
+	}
+}
+
+//reads up to about maxSize bytes ending at a line boundary. the rest of the last line is kept in leftover for the next call
+static void readGfaChunk(std::istream& file, std::string& leftover, std::string& block, size_t maxSize)
+{
+	block.swap(leftover);
+	leftover.clear();
+	while (file.good())
+	{
+		size_t oldSize = block.size();
+		block.resize(oldSize + maxSize);
+		file.read(&block[oldSize], maxSize);
+		block.resize(oldSize + file.gcount());
+		if (!file.good()) break;
+		size_t lastLineEnd = block.rfind('\n');
+		//a line longer than the chunk, keep reading
+		if (lastLineEnd == std::string::npos || lastLineEnd < oldSize) continue;
+		leftover.assign(block, lastLineEnd + 1, std::string::npos);
+		block.resize(lastLineEnd + 1);
+		break;
+	}
+}
+
+AlignmentGraph DirectedGraph::StreamGFAGraphFromFile(std::string filename, size_t numThreads)
+{
+	const size_t chunkSize = 16 * 1024 * 1024;
+	std::ifstream file { filename, std::ios::in | std::ios::binary };
+	//node id of each S line name, in order of the S lines. a later line for the same node replaces the earlier one
+	std::unordered_map<std::string, int> nameMapping;
+	std::vector<std::string> names;
+	//sequences of all nodes back to back instead of a string per node
+	std::string sequences;
+	std::vector<size_t> nodeSequenceStart;
+	std::vector<size_t> nodeSequenceEnd;
+	struct Edge
+	{
+		int from;
+		bool fromEnd;
+		int to;
+		bool toEnd;
+		size_t overlap;
+	};
+	std::vector<std::string> blocks;
+	std::vector<GfaChunk> chunks;
+	//the edges of every chunk, kept until the names of all nodes are known
+	std::vector<GfaChunk> edgeChunks;
+	blocks.resize(numThreads);
+	chunks.resize(numThreads);
+	std::string leftover;
+	while (file.good() || leftover.size() > 0)
+	{
+		size_t numBlocks = 0;
+		for (size_t i = 0; i < numThreads; i++)
+		{
+			if (!file.good() && leftover.size() == 0) break;
+			readGfaChunk(file, leftover, blocks[i], chunkSize);
+			numBlocks += 1;
+		}
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < numBlocks; i++)
+		{
+			threads.emplace_back([&blocks, &chunks, i]() { parseGfaChunk(blocks[i], chunks[i]); });
+		}
+		for (size_t i = 0; i < numBlocks; i++)
+		{
+			threads[i].join();
+		}
+		//only the node names go through the map here, in file order
+		for (size_t i = 0; i < numBlocks; i++)
+		{
+			GfaChunk& chunk = chunks[i];
+			if (chunk.error.size() > 0) throw CommonUtils::InvalidGraphException { chunk.error };
+			size_t sequenceOffset = sequences.size();
+			sequences += chunk.sequence;
+			for (size_t j = 0; j < chunk.nodeNames.size(); j++)
+			{
+				auto inserted = nameMapping.emplace(chunk.nodeNames[j], (int)names.size());
+				int id = inserted.first->second;
+				if (inserted.second)
+				{
+					names.push_back(chunk.nodeNames[j]);
+					nodeSequenceStart.push_back(0);
+					nodeSequenceEnd.push_back(0);
+				}
+				nodeSequenceStart[id] = sequenceOffset + (j == 0 ? 0 : chunk.nodeSequenceEnd[j-1]);
+				nodeSequenceEnd[id] = sequenceOffset + chunk.nodeSequenceEnd[j];
+			}
+			if (chunk.edges.size() == 0) continue;
+			edgeChunks.emplace_back();
+			edgeChunks.back().edgeNames.swap(chunk.edgeNames);
+			edgeChunks.back().edges.swap(chunk.edges);
+		}
+	}
+	blocks.clear();
+	chunks.clear();
+
+	//the map isn't modified anymore so the chunks can look up their edge endpoints in parallel
+	//edges between non-existant nodes are removed like in GfaGraph
+	std::vector<std::vector<Edge>> chunkEdges;
+	chunkEdges.resize(edgeChunks.size());
+	{
+		std::atomic<size_t> nextChunk { 0 };
+		std::vector<std::thread> threads;
+		for (size_t thread = 0; thread < numThreads; thread++)
+		{
+			threads.emplace_back([&edgeChunks, &chunkEdges, &nameMapping, &nextChunk]()
+			{
+				std::string name;
+				auto getId = [&nameMapping, &name](const std::string& names, size_t offset)
+				{
+					name.assign(names.c_str() + offset);
+					auto found = nameMapping.find(name);
+					if (found == nameMapping.end()) return -1;
+					return found->second;
+				};
+				while (true)
+				{
+					size_t chunk = nextChunk++;
+					if (chunk >= edgeChunks.size()) break;
+					std::vector<Edge>& result = chunkEdges[chunk];
+					result.reserve(edgeChunks[chunk].edges.size());
+					for (const auto& edge : edgeChunks[chunk].edges)
+					{
+						int from = getId(edgeChunks[chunk].edgeNames, edge.fromName);
+						int to = getId(edgeChunks[chunk].edgeNames, edge.toName);
+						if (from == -1 || to == -1) continue;
+						result.push_back(Edge { from, edge.fromEnd, to, edge.toEnd, edge.overlap });
+					}
+					edgeChunks[chunk].clear();
+					edgeChunks[chunk].edgeNames.shrink_to_fit();
+					edgeChunks[chunk].edges.shrink_to_fit();
+				}
+			});
+		}
+		for (size_t thread = 0; thread < numThreads; thread++)
+		{
+			threads[thread].join();
+		}
+	}
+	edgeChunks.clear();
+	nameMapping.clear();
+	std::vector<Edge> edges;
+	{
+		size_t numEdges = 0;
+		for (const auto& chunk : chunkEdges) numEdges += chunk.size();
+		edges.reserve(numEdges);
+		for (auto& chunk : chunkEdges)
+		{
+			edges.insert(edges.end(), chunk.begin(), chunk.end());
+			std::vector<Edge> tmp;
+			std::swap(chunk, tmp);
+		}
+	}
+
+	size_t edgeOverlap = std::numeric_limits<size_t>::max();
+	bool hasVaryingOverlaps = false;
+	for (const auto& edge : edges)
+	{
+		if (edgeOverlap != std::numeric_limits<size_t>::max() && edge.overlap != edgeOverlap) hasVaryingOverlaps = true;
+		edgeOverlap = edge.overlap;
+	}
+	if (hasVaryingOverlaps || edges.size() == 0) edgeOverlap = 0;
+
+	bool allIdsIntegers = true;
+	for (const auto& name : names)
+	{
+		char* p;
+		strtol(name.c_str(), &p, 10);
+		if (*p)
+		{
+			allIdsIntegers = false;
+			break;
+		}
+	}
+	std::vector<int> finalId;
+	finalId.resize(names.size());
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		finalId[i] = allIdsIntegers ? std::stoi(names[i]) : i;
+	}
+
+	//breakpoints of each directed node in CSR form, directed node of name i is i*2 forward and i*2+1 backward
+	std::vector<size_t> breakpointStart;
+	std::vector<size_t> breakpoints;
+	breakpointStart.resize(names.size() * 2 + 1, 0);
+	for (const auto& edge : edges)
+	{
+		size_t fromSize = nodeSequenceEnd[edge.from] - nodeSequenceStart[edge.from];
+		size_t toSize = nodeSequenceEnd[edge.to] - nodeSequenceStart[edge.to];
+		if (fromSize <= edge.overlap || toSize <= edge.overlap)
+		{
+			throw CommonUtils::InvalidGraphException { std::string{"Overlap between nodes "} + names[edge.from] + " and " + names[edge.to] + " is too big. Fix the overlap to be smaller than both nodes" };
+		}
+		breakpointStart[edge.from * 2 + (edge.fromEnd ? 1 : 0) + 1] += 1;
+		breakpointStart[edge.to * 2 + (edge.toEnd ? 0 : 1) + 1] += 1;
+	}
+	for (size_t i = 1; i < breakpointStart.size(); i++)
+	{
+		breakpointStart[i] += breakpointStart[i-1];
+	}
+	breakpoints.resize(breakpointStart.back());
+	{
+		std::vector<size_t> fillPos(breakpointStart.begin(), breakpointStart.end()-1);
+		for (const auto& edge : edges)
+		{
+			breakpoints[fillPos[edge.from * 2 + (edge.fromEnd ? 1 : 0)]++] = edge.overlap;
+			breakpoints[fillPos[edge.to * 2 + (edge.toEnd ? 0 : 1)]++] = edge.overlap;
+		}
+	}
+
+	AlignmentGraph result;
+	result.DBGoverlap = edgeOverlap;
+	std::string sequence;
+	std::vector<size_t> breakpointsFw;
+	std::vector<size_t> breakpointsBw;
+	std::string emptyName;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		sequence.assign(sequences, nodeSequenceStart[i], nodeSequenceEnd[i] - nodeSequenceStart[i]);
+		breakpointsFw.assign(breakpoints.begin() + breakpointStart[i * 2], breakpoints.begin() + breakpointStart[i * 2 + 1]);
+		breakpointsBw.assign(breakpoints.begin() + breakpointStart[i * 2 + 1], breakpoints.begin() + breakpointStart[i * 2 + 2]);
+		breakpointsFw.push_back(0);
+		breakpointsFw.push_back(sequence.size());
+		breakpointsBw.push_back(0);
+		breakpointsBw.push_back(sequence.size());
+		std::sort(breakpointsFw.begin(), breakpointsFw.end());
+		std::sort(breakpointsBw.begin(), breakpointsBw.end());
+		const std::string& name = allIdsIntegers ? emptyName : names[i];
+		result.AddNode(finalId[i] * 2, sequence, name, false, breakpointsFw);
+		result.AddNode(finalId[i] * 2 + 1, CommonUtils::ReverseComplement(sequence), name, true, breakpointsBw);
+	}
+	for (const auto& edge : edges)
+	{
+		auto pair = ConvertGFAEdgeToEdges(finalId[edge.from], edge.fromEnd ? "+" : "-", finalId[edge.to], edge.toEnd ? "+" : "-", edge.overlap);
+		result.AddEdgeNodeId(pair.first.fromId, pair.first.toId, pair.first.overlap);
+		result.AddEdgeNodeId(pair.second.fromId, pair.second.toId, pair.second.overlap);
+	}
+	result.Finalize(64);
+	return result;
+}
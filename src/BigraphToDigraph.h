@@ -34,6 +34,8 @@ public:
 	static AlignmentGraph BuildFromVG(const vg::Graph& graph);
 	static AlignmentGraph BuildFromGFA(const GfaGraph& graph);
 	static AlignmentGraph StreamVGGraphFromFile(std::string filename);
+	//parses the GFA in parallel chunks straight into the alignment graph without building a GfaGraph
+	static AlignmentGraph StreamGFAGraphFromFile(std::string filename, size_t numThreads);
 private:
 };
 
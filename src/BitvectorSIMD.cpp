@@ -0,0 +1,12 @@
+#include "BitvectorSIMD.h"
+
+namespace BitvectorSIMD
+{
+	bool hasAVX2 = false;
+	void detectCPU()
+	{
+#ifndef NOAVX2
+		hasAVX2 = __builtin_cpu_supports("avx2");
+#endif
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef BitvectorSIMD_h
+#define BitvectorSIMD_h
+
+#include <cstdint>
+#include <cstddef>
+#ifndef NOAVX2
+#include <immintrin.h>
+#endif
+
+//the Myers step for several independent columns at once, one column per 64-bit lane
+//the kernels are compiled for their instruction sets separately and picked at runtime, so the binary still runs on older CPUs
+namespace BitvectorSIMD
+{
+	constexpr size_t MaxLanes = 4;
+	//below this many columns the loads and stores cost more than the scalar steps
+	constexpr size_t MinLanes = 2;
+	extern bool hasAVX2;
+	void detectCPU();
+
+#ifndef NOAVX2
+	//http://www.gersteinlab.org/courses/452/09-spring/pdf/Myers.pdf
+	//same as GraphAlignerBitvectorCommon::getNextSlice, every column uses the same Eq
+	//VP and VN are updated in place, hinP and hinN are replaced with the horizontal delta out of the last row
+	__attribute__((target("avx2")))
+	inline void nextSlicesAVX2(uint64_t Eq, uint64_t* VP, uint64_t* VN, uint64_t* hinP, uint64_t* hinN)
+	{
+		__m256i vp = _mm256_loadu_si256((const __m256i*)VP);
+		__m256i vn = _mm256_loadu_si256((const __m256i*)VN);
+		__m256i hp = _mm256_loadu_si256((const __m256i*)hinP);
+		__m256i hn = _mm256_loadu_si256((const __m256i*)hinN);
+		__m256i eq = _mm256_set1_epi64x(Eq);
+		__m256i ones = _mm256_set1_epi64x(-1);
+		__m256i xv = _mm256_or_si256(eq, vn);
+		eq = _mm256_or_si256(eq, hn);
+		__m256i xh = _mm256_or_si256(_mm256_xor_si256(_mm256_add_epi64(_mm256_and_si256(eq, vp), vp), vp), eq);
+		__m256i ph = _mm256_or_si256(vn, _mm256_xor_si256(_mm256_or_si256(xh, vp), ones));
+		__m256i mh = _mm256_and_si256(vp, xh);
+		__m256i tempMh = _mm256_or_si256(_mm256_slli_epi64(mh, 1), hn);
+		__m256i tempPh = _mm256_or_si256(_mm256_slli_epi64(ph, 1), hp);
+		vp = _mm256_or_si256(tempMh, _mm256_xor_si256(_mm256_or_si256(xv, tempPh), ones));
+		vn = _mm256_and_si256(tempPh, xv);
+		_mm256_storeu_si256((__m256i*)VP, vp);
+		_mm256_storeu_si256((__m256i*)VN, vn);
+		_mm256_storeu_si256((__m256i*)hinP, _mm256_srli_epi64(ph, 63));
+		_mm256_storeu_si256((__m256i*)hinN, _mm256_srli_epi64(mh, 63));
+	}
+#endif
+}
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef ColinearChaining_h
+#define ColinearChaining_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include "ThreadReadAssertion.h"
+
+//dynamic programming chaining of anchors on one coordinate system, the read position and the diagonal (graph position - read position)
+//an anchor can follow any anchor earlier in the read which is at most maxSeqGap before it and whose diagonal is at most maxDiagonalDifference away
+//following costs one per diagonal difference. split by the sign of the difference the cost is linear,
+//so the best predecessor is a range maximum over the diagonals, one query for each side
+//an anchor scores weightPerBp for each of its bases past the end of its predecessor's match, so overlapping k-mer seeds don't count the same bases twice
+//predecessors whose match ends before the anchor starts are in one pair of range maxima and ones which overlap it in another
+class ColinearChaining
+{
+public:
+	struct Anchor
+	{
+		size_t seqPos;
+		int64_t diagonal;
+		size_t length;
+	};
+	struct Chain
+	{
+		//in read order
+		std::vector<size_t> anchors;
+		int64_t score;
+	};
+	static std::vector<Chain> getChains(const std::vector<Anchor>& anchors, int64_t weightPerBp, int64_t maxDiagonalDifference, size_t maxSeqGap)
+	{
+		return getChains(anchors, weightPerBp, maxDiagonalDifference, maxSeqGap, [](size_t from, size_t to) { return true; });
+	}
+	//chains by descending score, every anchor is in exactly one chain
+	//a chain which would continue into an anchor already used by a better chain stops there, and only scores its own part
+	//so does a chain where canFollow(predecessor, anchor) is false. it's only checked for the chosen predecessors, the range queries can't include it
+	template <typename CanFollowF>
+	static std::vector<Chain> getChains(const std::vector<Anchor>& anchors, int64_t weightPerBp, int64_t maxDiagonalDifference, size_t maxSeqGap, CanFollowF canFollow)
+	{
+		std::vector<size_t> bySeqPos;
+		std::vector<size_t> byDiagonal;
+		std::vector<size_t> byEnd;
+		for (size_t i = 0; i < anchors.size(); i++)
+		{
+			assert(anchors[i].length > 0);
+			bySeqPos.push_back(i);
+			byDiagonal.push_back(i);
+			byEnd.push_back(i);
+		}
+		std::sort(bySeqPos.begin(), bySeqPos.end(), [&anchors](size_t left, size_t right) { return anchors[left].seqPos < anchors[right].seqPos; });
+		std::sort(byEnd.begin(), byEnd.end(), [&anchors](size_t left, size_t right) { return anchors[left].seqPos + anchors[left].length < anchors[right].seqPos + anchors[right].length; });
+		std::sort(byDiagonal.begin(), byDiagonal.end(), [&anchors](size_t left, size_t right) { return anchors[left].diagonal < anchors[right].diagonal || (anchors[left].diagonal == anchors[right].diagonal && left < right); });
+		std::vector<int64_t> sortedDiagonals;
+		std::vector<size_t> diagonalRank;
+		diagonalRank.resize(anchors.size());
+		for (size_t i = 0; i < byDiagonal.size(); i++)
+		{
+			sortedDiagonals.push_back(anchors[byDiagonal[i]].diagonal);
+			diagonalRank[byDiagonal[i]] = i;
+		}
+		//score + diagonal for predecessors below the diagonal, score - diagonal for the ones above
+		//the overlapping predecessors also subtract their match end so the anchor can add the bases past it
+		RangeMax below { anchors.size() };
+		RangeMax above { anchors.size() };
+		RangeMax overlapBelow { anchors.size() };
+		RangeMax overlapAbove { anchors.size() };
+		std::vector<int64_t> score;
+		std::vector<size_t> predecessor;
+		score.resize(anchors.size());
+		predecessor.resize(anchors.size(), std::numeric_limits<size_t>::max());
+		size_t firstActive = 0;
+		size_t firstOverlapping = 0;
+		size_t i = 0;
+		while (i < bySeqPos.size())
+		{
+			size_t seqPos = anchors[bySeqPos[i]].seqPos;
+			while (anchors[bySeqPos[firstActive]].seqPos + maxSeqGap < seqPos)
+			{
+				below.set(diagonalRank[bySeqPos[firstActive]], RangeMax::None, 0);
+				above.set(diagonalRank[bySeqPos[firstActive]], RangeMax::None, 0);
+				overlapBelow.set(diagonalRank[bySeqPos[firstActive]], RangeMax::None, 0);
+				overlapAbove.set(diagonalRank[bySeqPos[firstActive]], RangeMax::None, 0);
+				firstActive += 1;
+			}
+			//matches which ended before this read position stop overlapping and score their successors fully
+			while (firstOverlapping < byEnd.size() && anchors[byEnd[firstOverlapping]].seqPos + anchors[byEnd[firstOverlapping]].length <= seqPos)
+			{
+				size_t anchor = byEnd[firstOverlapping];
+				firstOverlapping += 1;
+				overlapBelow.set(diagonalRank[anchor], RangeMax::None, 0);
+				overlapAbove.set(diagonalRank[anchor], RangeMax::None, 0);
+				if (anchors[anchor].seqPos + maxSeqGap < seqPos) continue;
+				below.set(diagonalRank[anchor], score[anchor] + anchors[anchor].diagonal, anchor);
+				above.set(diagonalRank[anchor], score[anchor] - anchors[anchor].diagonal, anchor);
+			}
+			//anchors at the same read position can't follow each other, so they are added only after all of them are scored
+			size_t end = i;
+			while (end < bySeqPos.size() && anchors[bySeqPos[end]].seqPos == seqPos) end += 1;
+			for (size_t j = i; j < end; j++)
+			{
+				size_t anchor = bySeqPos[j];
+				int64_t diagonal = anchors[anchor].diagonal;
+				int64_t weight = (int64_t)anchors[anchor].length * weightPerBp;
+				int64_t overlapWeight = (int64_t)(anchors[anchor].seqPos + anchors[anchor].length) * weightPerBp;
+				score[anchor] = weight;
+				size_t lowStart = std::lower_bound(sortedDiagonals.begin(), sortedDiagonals.end(), diagonal - maxDiagonalDifference) - sortedDiagonals.begin();
+				size_t middle = std::upper_bound(sortedDiagonals.begin(), sortedDiagonals.end(), diagonal) - sortedDiagonals.begin();
+				size_t highEnd = std::upper_bound(sortedDiagonals.begin(), sortedDiagonals.end(), diagonal + maxDiagonalDifference) - sortedDiagonals.begin();
+				consider(below.get(lowStart, middle), weight - diagonal, score[anchor], predecessor[anchor]);
+				consider(above.get(middle, highEnd), weight + diagonal, score[anchor], predecessor[anchor]);
+				consider(overlapBelow.get(lowStart, middle), overlapWeight - diagonal, score[anchor], predecessor[anchor]);
+				consider(overlapAbove.get(middle, highEnd), overlapWeight + diagonal, score[anchor], predecessor[anchor]);
+			}
+			//every match reaches past its own start, so new anchors begin as overlapping
+			for (size_t j = i; j < end; j++)
+			{
+				size_t anchor = bySeqPos[j];
+				int64_t matchEnd = (int64_t)(anchors[anchor].seqPos + anchors[anchor].length) * weightPerBp;
+				overlapBelow.set(diagonalRank[anchor], score[anchor] - matchEnd + anchors[anchor].diagonal, anchor);
+				overlapAbove.set(diagonalRank[anchor], score[anchor] - matchEnd - anchors[anchor].diagonal, anchor);
+			}
+			i = end;
+		}
+		std::vector<size_t> byScore = bySeqPos;
+		std::stable_sort(byScore.begin(), byScore.end(), [&score](size_t left, size_t right) { return score[left] > score[right]; });
+		std::vector<bool> used;
+		used.resize(anchors.size(), false);
+		std::vector<Chain> result;
+		for (size_t end : byScore)
+		{
+			if (used[end]) continue;
+			result.emplace_back();
+			size_t anchor = end;
+			while (true)
+			{
+				used[anchor] = true;
+				result.back().anchors.push_back(anchor);
+				if (predecessor[anchor] == std::numeric_limits<size_t>::max()) break;
+				if (used[predecessor[anchor]]) break;
+				if (!canFollow(predecessor[anchor], anchor)) break;
+				assert(anchors[predecessor[anchor]].seqPos < anchors[anchor].seqPos);
+				assert(anchors[predecessor[anchor]].seqPos + maxSeqGap >= anchors[anchor].seqPos);
+				assert(std::abs(anchors[anchor].diagonal - anchors[predecessor[anchor]].diagonal) <= maxDiagonalDifference);
+				anchor = predecessor[anchor];
+			}
+			//the first anchor only scores its own weight if the chain was cut before it
+			result.back().score = score[end] - score[anchor] + (int64_t)anchors[anchor].length * weightPerBp;
+			std::reverse(result.back().anchors.begin(), result.back().anchors.end());
+		}
+		std::stable_sort(result.begin(), result.end(), [](const Chain& left, const Chain& right) { return left.score > right.score; });
+		return result;
+	}
+private:
+	template <typename Pair>
+	static void consider(Pair best, int64_t add, int64_t& score, size_t& predecessor)
+	{
+		if (best.first == RangeMax::None) return;
+		if (best.first + add <= score) return;
+		score = best.first + add;
+		predecessor = best.second;
+	}
+	//segment tree of (value, anchor), maximum over index ranges
+	class RangeMax
+	{
+	public:
+		static constexpr int64_t None = std::numeric_limits<int64_t>::min();
+		RangeMax(size_t size) :
+		size(size),
+		tree()
+		{
+			tree.resize(size * 2, std::make_pair(None, 0));
+		}
+		void set(size_t index, int64_t value, size_t anchor)
+		{
+			assert(index < size);
+			index += size;
+			tree[index] = std::make_pair(value, anchor);
+			for (index /= 2; index > 0; index /= 2)
+			{
+				tree[index] = better(tree[index*2], tree[index*2+1]);
+			}
+		}
+		//maximum in [start, end)
+		std::pair<int64_t, size_t> get(size_t start, size_t end) const
+		{
+			assert(start <= end);
+			assert(end <= size);
+			std::pair<int64_t, size_t> result { None, 0 };
+			for (start += size, end += size; start < end; start /= 2, end /= 2)
+			{
+				if (start & 1)
+				{
+					result = better(result, tree[start]);
+					start += 1;
+				}
+				if (end & 1)
+				{
+					end -= 1;
+					result = better(result, tree[end]);
+				}
+			}
+			return result;
+		}
+	private:
+		static std::pair<int64_t, size_t> better(std::pair<int64_t, size_t> left, std::pair<int64_t, size_t> right)
+		{
+			return right.first > left.first ? right : left;
+		}
+		size_t size;
+		std::vector<std::pair<int64_t, size_t>> tree;
+	};
+};
+
+#endif
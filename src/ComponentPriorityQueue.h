@@ -4,6 +4,7 @@
 #include <queue>
 #include <phmap.h>
 #include "ThreadReadAssertion.h"
+#include "NodeBitvector.h"
 
 template <typename T, bool SparseStorage>
 class ComponentPriorityQueue
@@ -33,15 +34,15 @@ public:
 	{
 	}
 	template <bool Sparse = SparseStorage>
-	typename std::enable_if<Sparse>::type initialize(size_t maxNode)
+	typename std::enable_if<Sparse>::type initialize(size_t maxNode, bool sparseActive = false)
 	{
-		active.resize(maxNode, false);
+		active.resize(maxNode, sparseActive);
 	}
 	template <bool Sparse = SparseStorage>
-	typename std::enable_if<!Sparse>::type initialize(size_t maxNode)
+	typename std::enable_if<!Sparse>::type initialize(size_t maxNode, bool sparseActive = false)
 	{
 		extras.resize(maxNode);
-		active.resize(maxNode, false);
+		active.resize(maxNode, sparseActive);
 	}
 #ifdef NDEBUG
 	__attribute__((always_inline))
@@ -151,7 +152,7 @@ private:
 		return item.target;
 	}
 	std::priority_queue<PrioritizedItem, std::vector<PrioritizedItem>, std::greater<PrioritizedItem>> activeQueues;
-	std::vector<bool> active;
+	NodeBitvector active;
 	typename std::conditional<SparseStorage, phmap::flat_hash_map<size_t, std::vector<T>>, std::vector<std::vector<T>>>::type extras;
 };
 
@@ -0,0 +1,195 @@
+#ifndef DPArena_h
+#define DPArena_h
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <phmap.h>
+#include "ThreadReadAssertion.h"
+
+//monotonic memory for the DP tables of one extension. allocations bump a pointer and frees are ignored,
+//everything is released at once when the outermost scope ends. the chunks are kept in the thread's alignment state
+//so once a thread has seen a long read its DP containers stop calling malloc
+//large allocations go to the heap so that big temporary containers don't grow the arena
+class DPArena
+{
+public:
+	static constexpr size_t MinChunkSize = 1024 * 1024;
+	static constexpr size_t MaxArenaAllocation = 64 * 1024;
+	DPArena() :
+	allocations(0),
+	systemAllocations(0),
+	chunks(),
+	currentChunk(0),
+	currentOffset(0)
+	{
+	}
+	DPArena(const DPArena& other) = delete;
+	DPArena& operator=(const DPArena& other) = delete;
+	//containers created while a scope is alive allocate from its arena, and the arena is rewound to where it was when the scope ends
+	//so nothing allocated inside a scope may outlive it
+	class Scope
+	{
+	public:
+		Scope(DPArena& arena) :
+		arena(arena),
+		previous(current),
+		chunk(arena.currentChunk),
+		offset(arena.currentOffset)
+		{
+			current = &arena;
+		}
+		Scope(const Scope& other) = delete;
+		Scope& operator=(const Scope& other) = delete;
+		~Scope()
+		{
+			arena.currentChunk = chunk;
+			arena.currentOffset = offset;
+			current = previous;
+		}
+	private:
+		DPArena& arena;
+		DPArena* previous;
+		size_t chunk;
+		size_t offset;
+	};
+	//containers created while an enabled heap scope is alive use the heap even inside an arena scope,
+	//for DP data which is freed before the arena scope ends, see DPTable checkpointing
+	class HeapScope
+	{
+	public:
+		HeapScope(bool enabled) :
+		previous(current)
+		{
+			if (enabled) current = nullptr;
+		}
+		HeapScope(const HeapScope& other) = delete;
+		HeapScope& operator=(const HeapScope& other) = delete;
+		~HeapScope()
+		{
+			current = previous;
+		}
+	private:
+		DPArena* previous;
+	};
+	//the arena of the innermost scope on this thread, or null if there is none
+	static DPArena* active()
+	{
+		return current;
+	}
+	void* allocate(size_t bytes, size_t alignment)
+	{
+		assert(alignment <= alignof(std::max_align_t));
+		allocations += 1;
+		while (currentChunk < chunks.size())
+		{
+			size_t start = (currentOffset + alignment - 1) / alignment * alignment;
+			if (start + bytes <= chunks[currentChunk].size)
+			{
+				currentOffset = start + bytes;
+				return chunks[currentChunk].data.get() + start;
+			}
+			currentChunk += 1;
+			currentOffset = 0;
+		}
+		//new chunks double the arena so the number of mallocs is logarithmic in the largest table
+		size_t size = std::max(MinChunkSize, std::max(bytes, totalSize()));
+		chunks.emplace_back();
+		chunks.back().data.reset(new char[size]);
+		chunks.back().size = size;
+		systemAllocations += 1;
+		currentChunk = chunks.size()-1;
+		currentOffset = bytes;
+		return chunks.back().data.get();
+	}
+	size_t totalSize() const
+	{
+		size_t result = 0;
+		for (const auto& chunk : chunks) result += chunk.size;
+		return result;
+	}
+	//frees the chunks, only when no scope is alive
+	void clear()
+	{
+		assert(current != this);
+		chunks.clear();
+		currentChunk = 0;
+		currentOffset = 0;
+	}
+	void clearCounters()
+	{
+		allocations = 0;
+		systemAllocations = 0;
+	}
+	//allocations served from the chunks, and the mallocs made for new chunks and large allocations
+	size_t allocations;
+	size_t systemAllocations;
+private:
+	struct Chunk
+	{
+		std::unique_ptr<char[]> data;
+		size_t size;
+	};
+	std::vector<Chunk> chunks;
+	size_t currentChunk;
+	size_t currentOffset;
+	static thread_local DPArena* current;
+};
+
+inline thread_local DPArena* DPArena::current = nullptr;
+
+//takes the active arena when constructed and falls back to the heap if there is none
+template <typename T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+	ArenaAllocator() :
+	arena(DPArena::active())
+	{
+	}
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) :
+	arena(other.arena)
+	{
+	}
+	T* allocate(size_t n)
+	{
+		if (arena == nullptr) return std::allocator<T>{}.allocate(n);
+		if (n * sizeof(T) > DPArena::MaxArenaAllocation)
+		{
+			arena->systemAllocations += 1;
+			return std::allocator<T>{}.allocate(n);
+		}
+		return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(T* ptr, size_t n)
+	{
+		if (arena == nullptr || n * sizeof(T) > DPArena::MaxArenaAllocation) std::allocator<T>{}.deallocate(ptr, n);
+	}
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const
+	{
+		return arena == other.arena;
+	}
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const
+	{
+		return arena != other.arena;
+	}
+	DPArena* arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+template <typename K, typename V>
+using ArenaHashMap = phmap::flat_hash_map<K, V, phmap::Hash<K>, phmap::EqualTo<K>, ArenaAllocator<std::pair<const K, V>>>;
+template <typename K>
+using ArenaHashSet = phmap::flat_hash_set<K, phmap::Hash<K>, phmap::EqualTo<K>, ArenaAllocator<K>>;
+
+#endif
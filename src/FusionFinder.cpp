@@ -200,7 +200,7 @@ void addBestAlnsOnePair(std::unordered_map<size_t, FusionAlignment>& bestAlns, c
 		const auto& read = reads[readIndex];
 		try
 		{
-			auto alignments = AlignOneWay(alignmentGraph, read.seq_id, read.sequence, 1000, 1000, true, reusableState, true, true, false, false, 0, 0, 0);
+			auto alignments = AlignOneWay<size_t, uint64_t>(alignmentGraph, read.seq_id, read.sequence, 1000, 1000, true, reusableState, true, true, false, false, 0, 0, 0);
 			AddAlignment(read.seq_id, read.sequence, alignments.alignments[0]);
 			replaceDigraphNodeIdsWithOriginalNodeIds(*alignments.alignments[0].alignment, alignmentGraph);
 			if (alignments.alignments[0].alignment->score() > read.sequence.size() * maxScoreFraction) continue;
@@ -15,6 +15,8 @@
 #include "GraphAlignerGAFAlignment.h"
 #include "GraphAlignerBitvectorBanded.h"
 #include "GraphAlignerBitvectorDijkstra.h"
+#include "AlignerHelperPool.h"
+#include "ColinearChaining.h"
 
 template <typename LengthType, typename ScoreType, typename Word>
 class GraphAligner
@@ -31,6 +33,86 @@ private:
 	using OnewayTrace = typename Common::OnewayTrace;
 	using AlignerGraphsizedState = typename Common::AlignerGraphsizedState;
 	using TraceItem = typename Common::TraceItem;
+	using HelperPool = AlignerHelperPool<AlignerGraphsizedState>;
+	//seed extensions running on idle threads ahead of the seed loop
+	//results are used only when the loop reaches that seed so the alignments are the same as without them
+	class SpeculativeExtensions
+	{
+	public:
+		SpeculativeExtensions(HelperPool* pool, AlignerGraphsizedState& state, size_t numSeeds) :
+		pool(pool),
+		state(state),
+		cancel(std::make_shared<std::atomic<bool>>(false)),
+		results()
+		{
+			if (pool != nullptr) results.resize(numSeeds);
+		}
+		~SpeculativeExtensions()
+		{
+			//the tasks refer to the sequence and the aligner, wait for them even if they're not needed anymore
+			*cancel = true;
+			for (auto& result : results)
+			{
+				if (!result.valid()) continue;
+				wait(result);
+			}
+		}
+		bool started(size_t seed) const
+		{
+			return pool != nullptr && results[seed].valid();
+		}
+		size_t idleHelpers() const
+		{
+			if (pool == nullptr) return 0;
+			return pool->idleHelpers();
+		}
+		void start(size_t seed, std::function<AlignmentResult::AlignmentItem(AlignerGraphsizedState&)> task)
+		{
+			assert(pool != nullptr);
+			assert(!results[seed].valid());
+			results[seed] = pool->template submit<AlignmentResult::AlignmentItem>(task, cancel);
+		}
+		AlignmentResult::AlignmentItem get(size_t seed)
+		{
+			assert(started(seed));
+			wait(results[seed]);
+			return results[seed].get();
+		}
+	private:
+		void wait(std::future<AlignmentResult::AlignmentItem>& result)
+		{
+			waitHelping(pool, state, result);
+		}
+		HelperPool* pool;
+		AlignerGraphsizedState& state;
+		std::shared_ptr<std::atomic<bool>> cancel;
+		std::vector<std::future<AlignmentResult::AlignmentItem>> results;
+	};
+	//run queued tasks while waiting, otherwise nobody might pick this one up
+	//the tasks belong to other reads, so this read's assertion context and counters are put back after each one
+	template <typename T>
+	static void waitHelping(HelperPool* pool, AlignerGraphsizedState& state, std::future<T>& result)
+	{
+		while (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			auto context = ThreadReadAssertion::getContext();
+			auto counters = state.counters;
+			size_t allocations = state.arena.allocations;
+			size_t systemAllocations = state.arena.systemAllocations;
+			bool ranTask = pool->tryRunTask(state);
+			ThreadReadAssertion::setContext(context);
+			state.counters = counters;
+			state.arena.allocations = allocations;
+			state.arena.systemAllocations = systemAllocations;
+			if (!ranTask)
+			{
+				result.wait();
+				break;
+			}
+		}
+	}
+	//the backward and forward extensions of a seed run on two threads if both of them are at least this long
+	static constexpr size_t SplitExtensionMinLength = 20000;
 	const Params& params;
 	BitvectorAligner bvAligner;
 	DijkstraAligner dijkstraAligner;
@@ -78,13 +160,13 @@ public:
 		return result;
 	}
 
-	AlignmentResult AlignOneWayDijkstra(const std::string& seq_id, const std::string& sequence, AlignerGraphsizedState& reusableState) const
+	AlignmentResult AlignOneWayDijkstra(const std::string& seq_id, const std::string& sequence, AlignerGraphsizedState& reusableState, size_t heuristicKmerLength) const
 	{
 		AlignmentResult result;
 		result.readName = seq_id;
 		auto timeStart = std::chrono::system_clock::now();
 		assert(params.graph.finalized);
-		auto trace = getBacktraceDijkstra(sequence, reusableState);
+		auto trace = getBacktraceDijkstra(sequence, reusableState, heuristicKmerLength);
 		auto timeEnd = std::chrono::system_clock::now();
 		size_t time = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart).count();
 		//failed alignment, don't output
@@ -98,8 +180,8 @@ public:
 		AlignmentResult::AlignmentItem alnItem { std::move(trace), 0, std::numeric_limits<size_t>::max() };
 
 		alnItem.alignmentScore = alnItem.trace->score;
-		alnItem.alignmentStart = alnItem.trace->trace[0].DPposition.seqPos;
-		alnItem.alignmentEnd = alnItem.trace->trace.back().DPposition.seqPos + 1;
+		alnItem.alignmentStart = alnItem.trace->seqStart;
+		alnItem.alignmentEnd = alnItem.trace->seqEnd;
 		timeEnd = std::chrono::system_clock::now();
 		time = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart).count();
 		alnItem.elapsedMilliseconds = time;
@@ -124,7 +206,7 @@ public:
 		return result;
 	}
 
-	AlignmentResult AlignOneWay(const std::string& seq_id, const std::string& sequence, const std::vector<SeedHit>& seedHits, AlignerGraphsizedState& reusableState) const
+	AlignmentResult AlignOneWay(const std::string& seq_id, const std::string& sequence, const std::vector<SeedHit>& seedHits, AlignerGraphsizedState& reusableState, HelperPool* helperPool) const
 	{
 		assert(params.graph.finalized);
 		AlignmentResult result;
@@ -135,6 +217,8 @@ public:
 		if (params.seedExtendDensity == -1) extendSeeds = seedHits.size();
 		size_t worstExtendedSeedScore = 0;
 		std::string revSequence = CommonUtils::ReverseComplement(sequence);
+		SpeculativeExtensions speculative { helperPool, reusableState, seedHits.size() };
+		AlignmentCoverage coverage { sequence.size() };
 		for (size_t i = 0; i < seedHits.size(); i++)
 		{
 			if (params.sloppyOptimizations && ((params.nondeterministicOptimizations && seedHits[i].seedGoodness == seedScoreForEndToEndAln) || seedHits[i].seedGoodness < seedScoreForEndToEndAln))
@@ -155,39 +239,29 @@ public:
 				logger << BufferedWriter::Flush;
 				continue;
 			}
-			if (params.sloppyOptimizations)
+			if (params.sloppyOptimizations && coverage.overlaps(seedHits[i].seqPos, seedHits[i].seedGoodness, params.nondeterministicOptimizations))
 			{
-				bool found = false;
-				for (const auto& aln : result.alignments)
-				{
-					if (aln.alignmentStart <= seedHits[i].seqPos && aln.alignmentEnd >= seedHits[i].seqPos && (params.nondeterministicOptimizations || aln.seedGoodness > seedHits[i].seedGoodness))
-					{
-						logger << " skipped (overlap)";
-						logger << BufferedWriter::Flush;
-						found = true;
-						break;
-					}
-				}
-				if (found) continue;
+				logger << " skipped (overlap)";
+				logger << BufferedWriter::Flush;
+				continue;
 			}
-			bool found = false;
-			for (const auto& aln : result.alignments)
+			if (exactAlignmentPart(coverage, seedHits[i]))
 			{
-				if (exactAlignmentPart(aln, seedHits[i]))
-				{
-					logger << " skipped (existing alignment)";
-					logger << BufferedWriter::Flush;
-					found = true;
-					break;
-				}
+				logger << " skipped (existing alignment)";
+				logger << BufferedWriter::Flush;
+				continue;
 			}
-			if (found) continue;
 			logger << BufferedWriter::Flush;
 			worstExtendedSeedScore = seedHits[i].seedGoodness;
 			result.seedsExtended += 1;
-			auto item = getAlignmentFromSeed(seq_id, sequence, revSequence, seedHits[i], reusableState);
+			//keep a helper for the other direction of this seed if it's going to be split
+			size_t reservedHelpers = (!speculative.started(i) && splitExtension(sequence, seedHits[i])) ? 1 : 0;
+			if (!speculative.started(i) && speculative.idleHelpers() > reservedHelpers) startSpeculativeExtensions(speculative, seq_id, sequence, revSequence, seedHits, i+1, coverage, reservedHelpers);
+			auto item = speculative.started(i) ? speculative.get(i) : getAlignmentFromSeed(seq_id, sequence, revSequence, seedHits[i], reusableState, helperPool);
+			assertSetRead(seq_id, seedHits[i].nodeID, seedHits[i].reverse, seedHits[i].seqPos, seedHits[i].matchLen, seedHits[i].nodeOffset);
 			if (item.alignmentFailed()) continue;
 			item.seedGoodness = seedHits[i].seedGoodness;
+			coverage.add(item);
 			result.alignments.emplace_back(std::move(item));
 			if (params.sloppyOptimizations)
 			{
@@ -215,29 +289,35 @@ public:
 
 	void AddAlignment(const std::string& seq_id, const std::string& sequence, AlignmentResult::AlignmentItem& alignment) const
 	{
-		assert(alignment.trace->trace.size() > 0);
-		auto vgAln = VGAlignment::traceToAlignment(seq_id, sequence, alignment.trace->score, alignment.trace->trace, 0, false);
+		assert(alignment.trace->nodes.size() > 0);
+		auto vgAln = VGAlignment::traceToAlignment(seq_id, sequence, alignment.trace->score, *alignment.trace, 0, false);
 		alignment.alignment = vgAln;
 		alignment.alignment->set_sequence(sequence.substr(alignment.alignmentStart, alignment.alignmentEnd - alignment.alignmentStart));
 		alignment.alignment->set_query_position(alignment.alignmentStart);
 	}
 
-	void AddGAFLine(const std::string& seq_id, const std::string& sequence, AlignmentResult::AlignmentItem& alignment, bool cigarMatchMismatchMerge) const
+	void AddGAFLine(const std::string& seq_id, const std::string& sequence, const AlignmentResult::AlignmentItem& alignment, bool cigarMatchMismatchMerge, std::string& out) const
 	{
-		assert(alignment.trace->trace.size() > 0);
-		alignment.GAFline = GAFAlignment::traceToAlignment(seq_id, sequence, *alignment.trace, alignment.alignmentXScore, alignment.mappingQuality, params, cigarMatchMismatchMerge);
+		assert(alignment.trace->nodes.size() > 0);
+		GAFAlignment::traceToAlignment(seq_id, sequence, *alignment.trace, alignment.alignmentXScore, alignment.mappingQuality, params, cigarMatchMismatchMerge, out);
 	}
 
 	void AddCorrected(AlignmentResult::AlignmentItem& alignment) const
 	{
 		assert(alignment.trace != nullptr);
-		assert(alignment.trace->trace.size() > 0);
-		alignment.corrected.reserve(alignment.trace->trace.back().DPposition.seqPos - alignment.trace->trace[0].DPposition.seqPos);
-		alignment.corrected = alignment.trace->trace[0].graphCharacter;
-		for (size_t i = 1; i < alignment.trace->trace.size(); i++)
+		assert(alignment.trace->nodes.size() > 0);
+		const CompactTrace& trace = *alignment.trace;
+		alignment.corrected.clear();
+		alignment.corrected.reserve(trace.seqEnd - trace.seqStart);
+		//the graph sequence of each visit, inserted bases don't move in the graph
+		for (const auto& visit : trace.nodes)
 		{
-			if (!alignment.trace->trace[i-1].nodeSwitch && alignment.trace->trace[i].DPposition.nodeOffset == alignment.trace->trace[i-1].DPposition.nodeOffset && alignment.trace->trace[i].DPposition.node == alignment.trace->trace[i-1].DPposition.node) continue;
-			alignment.corrected += alignment.trace->trace[i].graphCharacter;
+			size_t unitigNode = params.graph.GetUnitigNode(visit.nodeId, visit.startOffset);
+			for (size_t offset = visit.startOffset; offset <= visit.endOffset; offset++)
+			{
+				if (offset >= params.graph.nodeOffset[unitigNode] + params.graph.NodeLength(unitigNode)) unitigNode = params.graph.GetUnitigNode(visit.nodeId, offset);
+				alignment.corrected += params.graph.NodeSequences(unitigNode, offset - params.graph.nodeOffset[unitigNode]);
+			}
 		}
 	}
 
@@ -282,7 +362,8 @@ public:
 
 	void orderSeedsByChaining(std::vector<SeedHit>& seedHits) const
 	{
-		phmap::flat_hash_map<size_t, std::vector<std::pair<size_t, size_t>>> seedPoses;
+		//seed index, node, diagonal
+		phmap::flat_hash_map<size_t, std::vector<std::tuple<size_t, size_t, int64_t>>> seedPoses;
 		for (size_t i = 0; i < seedHits.size(); i++)
 		{
 			int forwardNodeId;
@@ -300,44 +381,49 @@ public:
 				nodeIndex = params.graph.GetUnitigNode(forwardNodeId, seedHits[i].nodeOffset);
 				assert(seedHits[i].nodeOffset >= params.graph.nodeOffset[nodeIndex]);
 				realOffset = seedHits[i].nodeOffset - params.graph.nodeOffset[nodeIndex];
-				assert(params.graph.chainApproxPos[nodeIndex] + realOffset >= seedHits[i].seqPos);
 			}
 			else
 			{
 				nodeIndex = seedHits[i].alignmentGraphNodeId;
 				realOffset = seedHits[i].alignmentGraphNodeOffset;
-				assert(params.graph.chainApproxPos[nodeIndex] + realOffset >= seedHits[i].seqPos);
 			}
-			seedPoses[params.graph.chainNumber[nodeIndex]].emplace_back(i, params.graph.chainApproxPos[nodeIndex] + realOffset - seedHits[i].seqPos);
-		}
+			assert(realOffset < params.graph.NodeLength(nodeIndex));
+			assert(params.graph.ApproxPosition(nodeIndex, realOffset) <= (size_t)std::numeric_limits<int64_t>::max());
+			seedPoses[params.graph.ConnectedComponent(nodeIndex)].emplace_back(i, nodeIndex, (int64_t)params.graph.ApproxPosition(nodeIndex, realOffset) - (int64_t)seedHits[i].seqPos);
+		}
+		//seeds are chained within each connected component on approximate coordinates, so chains can continue across bubbles and tangles
+		//the chain's score and size go to all of its seeds so they are extended best chain first
+		//scores are in units of 1/ChainingScoreScale bp, so following an anchor costs 1/ChainingScoreScale per bp of diagonal difference
+		constexpr int64_t ChainingScoreScale = 5;
+		constexpr int64_t MaxDiagonalDifference = 500;
+		constexpr size_t MaxSeqGap = 5000;
+		std::vector<ColinearChaining::Anchor> anchors;
 		for (auto& pair : seedPoses)
 		{
-			std::sort(pair.second.begin(), pair.second.end(), [](std::pair<size_t, size_t> left, std::pair<size_t, size_t> right) { return left.second < right.second; });
-			size_t clusterStart = 0;
-			for (size_t i = 1; i <= pair.second.size(); i++)
-			{
-				assert(i == pair.second.size() || pair.second[i].second >= pair.second[i-1].second);
-				if (i < pair.second.size() && pair.second[i].second <= pair.second[i-1].second + 100) continue;
-				assert(i > clusterStart);
-				std::sort(pair.second.begin()+clusterStart, pair.second.begin()+i, [&seedHits](std::pair<size_t, size_t> left, std::pair<size_t, size_t> right) { return seedHits[left.first].seqPos < seedHits[right.first].seqPos; });
-				size_t matchingBps = 0;
-				int lastEnd = std::numeric_limits<int>::min();
-				for (size_t j = clusterStart; j < i; j++)
+			anchors.clear();
+			const auto& seeds = pair.second;
+			for (auto seed : seeds)
+			{
+				anchors.push_back(ColinearChaining::Anchor { seedHits[std::get<0>(seed)].seqPos, std::get<2>(seed), seedHits[std::get<0>(seed)].matchLen });
+			}
+			auto chains = ColinearChaining::getChains(anchors, ChainingScoreScale, MaxDiagonalDifference, MaxSeqGap, [this, &seeds](size_t from, size_t to)
+			{
+				return params.graph.MaybeReachable(std::get<1>(seeds[from]), std::get<1>(seeds[to]));
+			});
+			for (const auto& chain : chains)
+			{
+				size_t matchingBps = std::max(chain.score, (int64_t)0) / ChainingScoreScale;
+				for (size_t j = 1; j < chain.anchors.size(); j++)
 				{
-					int thisStart = (int)seedHits[pair.second[j].first].seqPos - (int)seedHits[pair.second[j].first].matchLen + 1;
-					int thisEnd = (int)seedHits[pair.second[j].first].seqPos;
-					assert(thisEnd >= lastEnd);
-					assert(thisEnd > thisStart);
-					matchingBps += (thisEnd - std::max(thisStart, lastEnd));
-					// matchingBps += seedHits[pair.second[j].first].rawSeedGoodness;
-					lastEnd = thisEnd;
+					assert(seedHits[std::get<0>(seeds[chain.anchors[j-1]])].seqPos < seedHits[std::get<0>(seeds[chain.anchors[j]])].seqPos);
+					assert(std::abs(std::get<2>(seeds[chain.anchors[j]]) - std::get<2>(seeds[chain.anchors[j-1]])) <= MaxDiagonalDifference);
+					assert(params.graph.MaybeReachable(std::get<1>(seeds[chain.anchors[j-1]]), std::get<1>(seeds[chain.anchors[j]])));
 				}
-				for (size_t j = clusterStart; j < i; j++)
+				for (auto anchor : chain.anchors)
 				{
-					seedHits[pair.second[j].first].seedGoodness = matchingBps + seedHits[pair.second[j].first].rawSeedGoodness;
-					seedHits[pair.second[j].first].seedClusterSize = i - clusterStart;
+					seedHits[std::get<0>(seeds[anchor])].seedGoodness = matchingBps + seedHits[std::get<0>(seeds[anchor])].rawSeedGoodness;
+					seedHits[std::get<0>(seeds[anchor])].seedClusterSize = chain.anchors.size();
 				}
-				clusterStart = i;
 			}
 		}
 		std::sort(seedHits.begin(), seedHits.end(), [](const SeedHit& left, const SeedHit& right) { return left.seedGoodness < right.seedGoodness; });
@@ -424,8 +510,8 @@ private:
 		AlignmentResult::AlignmentItem alnItem { std::move(mergedTrace), 0, std::numeric_limits<size_t>::max() };
 
 		alnItem.alignmentScore = alnItem.trace->score;
-		alnItem.alignmentStart = alnItem.trace->trace[0].DPposition.seqPos;
-		alnItem.alignmentEnd = alnItem.trace->trace.back().DPposition.seqPos + 1;
+		alnItem.alignmentStart = alnItem.trace->seqStart;
+		alnItem.alignmentEnd = alnItem.trace->seqEnd;
 		timeEnd = std::chrono::system_clock::now();
 		auto time = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart).count();
 		alnItem.elapsedMilliseconds = time;
@@ -433,66 +519,17 @@ private:
 		return alnItem;
 	}
 
-	bool exactAlignmentPart(const AlignmentResult::AlignmentItem& aln, const SeedHit& seedHit) const
+	bool exactAlignmentPart(const AlignmentCoverage& coverage, const SeedHit& seedHit) const
 	{
-		assert(aln.trace != nullptr);
-		const std::vector<TraceItem>& trace = aln.trace->trace;
-		assert(trace.size() > 0);
-		assert(trace.back().DPposition.seqPos > trace[0].DPposition.seqPos);
-		if (trace.back().DPposition.seqPos < seedHit.seqPos) return false;
-		if (trace[0].DPposition.seqPos > seedHit.seqPos) return false;
-		size_t high = trace.size();
-		size_t low = 0;
-		size_t mid = (seedHit.seqPos - trace[0].DPposition.seqPos) / (trace.back().DPposition.seqPos - trace[0].DPposition.seqPos);
-		while (trace[mid].DPposition.seqPos != seedHit.seqPos)
-		{
-			if (trace[mid].DPposition.seqPos < seedHit.seqPos)
-			{
-				low = mid;
-				mid = (high + low) / 2;
-				if (mid == low) mid += 1;
-				assert(mid < trace.size());
-			}
-			if (trace[mid].DPposition.seqPos > seedHit.seqPos)
-			{
-				high = mid;
-				mid = (high + low) / 2;
-				assert(mid < trace.size());
-			}
-			assert(low < mid);
-			assert(mid < high);
-		}
-		assert(mid < trace.size());
-		assert(trace[mid].DPposition.seqPos == seedHit.seqPos);
-		size_t down = mid;
-		size_t compareNode = seedHit.nodeID * 2;
+		int compareNode = seedHit.nodeID * 2;
 		if (seedHit.reverse) compareNode += 1;
-		while (trace[down].DPposition.seqPos == seedHit.seqPos)
-		{
-			if (compareNode == trace[down].DPposition.node && seedHit.nodeOffset == trace[down].DPposition.nodeOffset)
-			{
-				return true;
-			}
-			if (down == 0) break;
-			down -= 1;
-		}
-		size_t up = mid;
-		while (trace[up].DPposition.seqPos == seedHit.seqPos)
-		{
-			if (compareNode == trace[up].DPposition.node && seedHit.nodeOffset == trace[up].DPposition.nodeOffset)
-			{
-				return true;
-			}
-			up += 1;
-			if (up == trace.size()) break;
-		}
-		return false;
+		return coverage.containsCell(seedHit.seqPos, compareNode, seedHit.nodeOffset);
 	}
 
-	OnewayTrace getBacktraceDijkstra(const std::string& sequence, AlignerGraphsizedState& reusableState) const
+	OnewayTrace getBacktraceDijkstra(const std::string& sequence, AlignerGraphsizedState& reusableState, size_t heuristicKmerLength) const
 	{
 		std::string_view seq { sequence.data(), sequence.size() };
-		return dijkstraAligner.getBacktraceFullStart(seq, params.forceGlobal, reusableState);
+		return dijkstraAligner.getBacktraceFullStart(seq, params.forceGlobal, reusableState, heuristicKmerLength);
 	}
 
 	OnewayTrace getBacktraceFullStart(const std::string& sequence, AlignerGraphsizedState& reusableState) const
@@ -511,7 +548,12 @@ private:
 		return bvAligner.getMultiseedTraces(sequence, seedHits, reusableState);
 	}
 
-	Trace getTwoDirectionalTrace(const std::string& sequence, const std::string& revSequence, SeedHit seedHit, AlignerGraphsizedState& reusableState) const
+	bool splitExtension(const std::string& sequence, const SeedHit& seedHit) const
+	{
+		return seedHit.seqPos >= SplitExtensionMinLength && sequence.size() - seedHit.seqPos >= SplitExtensionMinLength;
+	}
+
+	Trace getTwoDirectionalTrace(const std::string& seq_id, const std::string& sequence, const std::string& revSequence, SeedHit seedHit, AlignerGraphsizedState& reusableState, HelperPool* helperPool) const
 	{
 		assert(seedHit.seqPos >= 0);
 		assert(seedHit.seqPos < sequence.size());
@@ -530,18 +572,46 @@ private:
 		Trace result;
 		result.backward.score = std::numeric_limits<ScoreType>::max();
 		result.forward.score = std::numeric_limits<ScoreType>::max();
+		//the two directions are independent until they're merged, so with an idle helper the backward one runs there with its own state
+		std::future<OnewayTrace> backwardResult;
 		if (seedHit.seqPos > 0)
 		{
 			std::string_view backwardPart { revSequence.data() + revSequence.size() - seedHit.seqPos, seedHit.seqPos };
 			auto reversePos = params.graph.GetReversePosition(forwardNodeId, seedHit.nodeOffset);
 			assert(reversePos.first == backwardNodeId);
-			result.backward = bvAligner.getReverseTraceFromSeed(backwardPart, backwardNodeId, reversePos.second, params.forceGlobal, params.Xdropcutoff, reusableState);
+			if (helperPool != nullptr && helperPool->idleHelpers() > 0 && splitExtension(sequence, seedHit))
+			{
+				size_t backwardOffset = reversePos.second;
+				backwardResult = helperPool->template submit<OnewayTrace>([this, &seq_id, seedHit, backwardPart, backwardNodeId, backwardOffset](AlignerGraphsizedState& state)
+				{
+					assertSetRead(seq_id, seedHit.nodeID, seedHit.reverse, seedHit.seqPos, seedHit.matchLen, seedHit.nodeOffset);
+					return bvAligner.getReverseTraceFromSeed(backwardPart, backwardNodeId, backwardOffset, params.forceGlobal, params.Xdropcutoff, state);
+				}, std::make_shared<std::atomic<bool>>(false));
+			}
+			else
+			{
+				result.backward = bvAligner.getReverseTraceFromSeed(backwardPart, backwardNodeId, reversePos.second, params.forceGlobal, params.Xdropcutoff, reusableState);
+			}
+		}
+		try
+		{
+			if (seedHit.seqPos < sequence.size()-1)
+			{
+				std::string_view forwardPart { sequence.data() + seedHit.seqPos + 1, sequence.size() - seedHit.seqPos - 1 };
+				size_t offset = seedHit.nodeOffset;
+				result.forward = bvAligner.getReverseTraceFromSeed(forwardPart, forwardNodeId, offset, params.forceGlobal, params.Xdropcutoff, reusableState);
+			}
+		}
+		catch (...)
+		{
+			//the task refers to the sequence, don't leave before it's done
+			if (backwardResult.valid()) waitHelping(helperPool, reusableState, backwardResult);
+			throw;
 		}
-		if (seedHit.seqPos < sequence.size()-1)
+		if (backwardResult.valid())
 		{
-			std::string_view forwardPart { sequence.data() + seedHit.seqPos + 1, sequence.size() - seedHit.seqPos - 1 };
-			size_t offset = seedHit.nodeOffset;
-			result.forward = bvAligner.getReverseTraceFromSeed(forwardPart, forwardNodeId, offset, params.forceGlobal, params.Xdropcutoff, reusableState);
+			waitHelping(helperPool, reusableState, backwardResult);
+			result.backward = backwardResult.get();
 		}
 
 		if (!result.backward.failed())
@@ -651,15 +721,11 @@ private:
 			ScoreType alignmentXScore = (ScoreType)(mergedTrace.trace.back().DPposition.seqPos - mergedTrace.trace[0].DPposition.seqPos + 1)*100 - params.XscoreErrorCost * (ScoreType)mergedTrace.score;
 			if (alignmentXScore <= 0) continue;
 			result.emplace_back(std::move(mergedTrace), 0, std::numeric_limits<size_t>::max());
-			LengthType seqstart = 0;
-			LengthType seqend = 0;
-			assert(result.back().trace->trace.size() > 0);
-			seqstart = result.back().trace->trace[0].DPposition.seqPos;
-			seqend = result.back().trace->trace.back().DPposition.seqPos;
-			assert(seqend < sequence.size());
+			assert(result.back().trace->nodes.size() > 0);
+			assert(result.back().trace->seqEnd <= sequence.size());
 			result.back().alignmentScore = result.back().trace->score;
-			result.back().alignmentStart = seqstart;
-			result.back().alignmentEnd = seqend + 1;
+			result.back().alignmentStart = result.back().trace->seqStart;
+			result.back().alignmentEnd = result.back().trace->seqEnd;
 			result.back().alignmentXScore = (ScoreType)result.back().alignmentLength()*100 - params.XscoreErrorCost * (ScoreType)result.back().alignmentScore;
 			assert(result.back().alignmentXScore == alignmentXScore);
 			result.back().alignmentXScore /= 100.0;
@@ -667,12 +733,36 @@ private:
 		return result;
 	}
 
-	AlignmentResult::AlignmentItem getAlignmentFromSeed(const std::string& seq_id, const std::string& sequence, const std::string& revSequence, SeedHit seedHit, AlignerGraphsizedState& reusableState) const
+	//hand the next seeds which would be extended with the current alignments to idle threads
+	void startSpeculativeExtensions(SpeculativeExtensions& speculative, const std::string& seq_id, const std::string& sequence, const std::string& revSequence, const std::vector<SeedHit>& seedHits, size_t firstSeed, const AlignmentCoverage& coverage, size_t reservedHelpers) const
+	{
+		size_t numStarted = 0;
+		size_t idle = speculative.idleHelpers();
+		if (idle <= reservedHelpers) return;
+		size_t maxStarted = idle - reservedHelpers;
+		for (size_t i = firstSeed; i < seedHits.size() && numStarted < maxStarted; i++)
+		{
+			if (speculative.started(i)) continue;
+			if (seedHits[i].seedClusterSize < params.minSeedClusterSize) continue;
+			if (params.sloppyOptimizations && coverage.overlaps(seedHits[i].seqPos, seedHits[i].seedGoodness, params.nondeterministicOptimizations)) continue;
+			if (exactAlignmentPart(coverage, seedHits[i])) continue;
+			const SeedHit& seedHit = seedHits[i];
+			speculative.start(i, [this, &seq_id, &sequence, &revSequence, &seedHit](AlignerGraphsizedState& state)
+			{
+				assertSetRead(seq_id, seedHit.nodeID, seedHit.reverse, seedHit.seqPos, seedHit.matchLen, seedHit.nodeOffset);
+				return getAlignmentFromSeed(seq_id, sequence, revSequence, seedHit, state, nullptr);
+			});
+			numStarted += 1;
+		}
+	}
+
+	//helperPool can be null, then both directions are aligned on this thread
+	AlignmentResult::AlignmentItem getAlignmentFromSeed(const std::string& seq_id, const std::string& sequence, const std::string& revSequence, SeedHit seedHit, AlignerGraphsizedState& reusableState, HelperPool* helperPool) const
 	{
 		assert(params.graph.finalized);
 		auto timeStart = std::chrono::system_clock::now();
 
-		auto trace = getTwoDirectionalTrace(sequence, revSequence, seedHit, reusableState);
+		auto trace = getTwoDirectionalTrace(seq_id, sequence, revSequence, seedHit, reusableState, helperPool);
 
 #ifndef NDEBUG
 		if (trace.forward.trace.size() > 0) verifyTrace(trace.forward.trace, sequence, trace.forward.score);
@@ -712,16 +802,12 @@ private:
 
 		AlignmentResult::AlignmentItem result { std::move(mergedTrace), 0, std::numeric_limits<size_t>::max() };
 
-		LengthType seqstart = 0;
-		LengthType seqend = 0;
-		assert(result.trace->trace.size() > 0);
-		seqstart = result.trace->trace[0].DPposition.seqPos;
-		seqend = result.trace->trace.back().DPposition.seqPos;
-		assert(seqend < sequence.size());
+		assert(result.trace->nodes.size() > 0);
+		assert(result.trace->seqEnd <= sequence.size());
 		// result.trace = traceVector;
 		result.alignmentScore = result.trace->score;
-		result.alignmentStart = seqstart;
-		result.alignmentEnd = seqend + 1;
+		result.alignmentStart = result.trace->seqStart;
+		result.alignmentEnd = result.trace->seqEnd;
 		auto timeEnd = std::chrono::system_clock::now();
 		size_t time = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - timeStart).count();
 		result.elapsedMilliseconds = time;
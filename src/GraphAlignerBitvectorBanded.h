@@ -45,9 +45,11 @@ public:
 
 	std::vector<OnewayTrace> getMultiseedTraces(const std::string_view& sequence, const std::vector<SeedHit>& seedHits, AlignerGraphsizedState& reusableState) const
 	{
+		DPArena::Scope arenaScope { reusableState.arena };
 		size_t numSlices = (sequence.size() + WordConfiguration<Word>::WordSize - 1) / WordConfiguration<Word>::WordSize;
 		auto initialSlice = BV::getInitialEmptySlice();
 		auto slice = getMultiseedSlices(sequence, initialSlice, numSlices, reusableState, seedHits);
+		reusableState.counters.slices += slice.slices.size();
 		std::vector<OnewayTrace> results = BV::getLocalMaximaTracesFromTable(params, sequence, slice, reusableState, true, true);
 		removeDuplicateTraces(results);
 		for (size_t i = 0; i < results.size(); i++)
@@ -59,6 +61,7 @@ public:
 
 	OnewayTrace getReverseTraceFromSeed(const std::string_view& sequence, int bigraphNodeId, size_t nodeOffset, bool forceGlobal, int Xdropcutoff, AlignerGraphsizedState& reusableState) const
 	{
+		DPArena::Scope arenaScope { reusableState.arena };
 		size_t numSlices = (sequence.size() + WordConfiguration<Word>::WordSize - 1) / WordConfiguration<Word>::WordSize;
 		auto initialBandwidth = BV::getInitialSliceExactPosition(params, bigraphNodeId, nodeOffset);
 		auto slice = getSlices(sequence, initialBandwidth, numSlices, forceGlobal, Xdropcutoff, reusableState);
@@ -87,6 +90,7 @@ public:
 	OnewayTrace getBacktraceFullStart(const std::string_view& originalSequence, bool forceGlobal, int Xdropcutoff, AlignerGraphsizedState& reusableState) const
 	{
 		assert(originalSequence.size() > 1);
+		DPArena::Scope arenaScope { reusableState.arena };
 		DPSlice startSlice;
 		startSlice.j = -WordConfiguration<Word>::WordSize;
 		startSlice.scores.addEmptyNodeMap(params.graph.NodeSize());
@@ -185,7 +189,7 @@ private:
 
 #ifdef EXTRACORRECTNESSASSERTIONS
 	template <bool HasVectorMap, bool PreviousHasVectorMap>
-	void checkNodeBoundaryCorrectness(const NodeSlice<LengthType, ScoreType, Word, HasVectorMap>& currentSlice, const NodeSlice<LengthType, ScoreType, Word, PreviousHasVectorMap>& previousSlice, const std::string_view& sequence, size_t j, ScoreType maxScore, ScoreType previousMaxScore, const std::vector<bool>& hasSeedStart, const WordSlice seedstartSlice, const WordSlice fakeSlice) const
+	void checkNodeBoundaryCorrectness(const NodeSlice<LengthType, ScoreType, Word, HasVectorMap>& currentSlice, const NodeSlice<LengthType, ScoreType, Word, PreviousHasVectorMap>& previousSlice, const std::string_view& sequence, size_t j, ScoreType maxScore, ScoreType previousMaxScore, const NodeBitvector& hasSeedStart, const WordSlice seedstartSlice, const WordSlice fakeSlice) const
 	{
 		assert(previousMaxScore <= maxScore || seedstartSlice.getScoreBeforeStart() <= maxScore);
 		for (auto pair : currentSlice)
@@ -244,7 +248,7 @@ private:
 #endif
 
 	template <bool HasVectorMap, bool PreviousHasVectorMap, typename PriorityQueue>
-	void addSeedHitToScoresAndQueue(const SeedHit& seedHit, NodeSlice<LengthType, ScoreType, Word, HasVectorMap>& currentSlice, const NodeSlice<LengthType, ScoreType, Word, PreviousHasVectorMap>& previousSlice, std::vector<bool>& currentBand, const std::vector<bool>& previousBand, PriorityQueue& calculableQueue, const WordSlice extraSlice, phmap::flat_hash_map<size_t, ScoreType>& nodeMaxExactEndposScore, bool storeNodeExactEndposScores) const
+	void addSeedHitToScoresAndQueue(const SeedHit& seedHit, NodeSlice<LengthType, ScoreType, Word, HasVectorMap>& currentSlice, const NodeSlice<LengthType, ScoreType, Word, PreviousHasVectorMap>& previousSlice, NodeBitvector& currentBand, const NodeBitvector& previousBand, PriorityQueue& calculableQueue, const WordSlice extraSlice, ArenaHashMap<size_t, ScoreType>& nodeMaxExactEndposScore, bool storeNodeExactEndposScores) const
 	{
 #ifdef SLICEVERBOSE
 		std::cerr << " " << seedHit.alignmentGraphNodeId << "(" << seedHit.nodeID << ")";
@@ -269,7 +273,7 @@ private:
 	}
 
 	template <bool HasVectorMap, bool PreviousHasVectorMap, typename PriorityQueue>
-	NodeCalculationResult calculateSlice(const std::string_view& sequence, const size_t j, NodeSlice<LengthType, ScoreType, Word, HasVectorMap>& currentSlice, const NodeSlice<LengthType, ScoreType, Word, PreviousHasVectorMap>& previousSlice, std::vector<bool>& currentBand, const std::vector<bool>& previousBand, PriorityQueue& calculableQueue, ScoreType previousQuitScore, int bandwidth, ScoreType previousMinScore, const std::vector<SeedHit>& seedHits, size_t seedhitStart, size_t seedhitEnd, const WordSlice seedstartSlice, std::vector<bool>& hasSeedStart, std::unordered_set<size_t>& seedstartNodes, phmap::flat_hash_map<size_t, ScoreType>& nodeMaxExactEndposScore, bool storeNodeExactEndposScores) const
+	NodeCalculationResult calculateSlice(const std::string_view& sequence, const size_t j, NodeSlice<LengthType, ScoreType, Word, HasVectorMap>& currentSlice, const NodeSlice<LengthType, ScoreType, Word, PreviousHasVectorMap>& previousSlice, NodeBitvector& currentBand, const NodeBitvector& previousBand, PriorityQueue& calculableQueue, ScoreType previousQuitScore, int bandwidth, ScoreType previousMinScore, const std::vector<SeedHit>& seedHits, size_t seedhitStart, size_t seedhitEnd, const WordSlice seedstartSlice, NodeBitvector& hasSeedStart, ArenaHashSet<size_t>& seedstartNodes, ArenaHashMap<size_t, ScoreType>& nodeMaxExactEndposScore, bool storeNodeExactEndposScores) const
 	{
 		if (previousMinScore == std::numeric_limits<ScoreType>::max() - bandwidth - 1)
 		{
@@ -308,7 +312,7 @@ private:
 		EqVector EqV = BV::getEqVector(sequence, j);
 
 		assert(previousSlice.size() > 0 || seedhitStart != std::numeric_limits<size_t>::max());
-		ScoreType zeroScore = previousMinScore*priorityMismatchPenalty - j - 64;
+		ScoreType zeroScore = previousMinScore*priorityMismatchPenalty - j - WordConfiguration<Word>::WordSize;
 		if (j == 0)
 		{
 			for (auto node : previousSlice)
@@ -358,7 +362,7 @@ private:
 		std::cerr << "seeds";
 #endif
 
-		std::vector<size_t> clearSeedStarts;
+		ArenaVector<size_t> clearSeedStarts;
 		if (seedstartSlice.getScoreBeforeStart() < previousQuitScore + WordConfiguration<Word>::WordSize)
 		{
 #ifdef SLICEVERBOSE
@@ -547,7 +551,7 @@ private:
 	}
 
 	template <typename PriorityQueue>
-	void fillDPSlice(const std::string_view& sequence, DPSlice& slice, const DPSlice& previousSlice, const std::vector<bool>& previousBand, std::vector<bool>& currentBand, PriorityQueue& calculableQueue, int bandwidth, const std::vector<SeedHit>& seedHits, size_t seedhitStart, size_t seedhitEnd, const WordSlice extraSlice, std::vector<bool>& hasSeedStart, bool viterbi, bool storeNodeExactEndposScores) const
+	void fillDPSlice(const std::string_view& sequence, DPSlice& slice, const DPSlice& previousSlice, const NodeBitvector& previousBand, NodeBitvector& currentBand, PriorityQueue& calculableQueue, int bandwidth, const std::vector<SeedHit>& seedHits, size_t seedhitStart, size_t seedhitEnd, const WordSlice extraSlice, NodeBitvector& hasSeedStart, bool viterbi, bool storeNodeExactEndposScores) const
 	{
 		NodeCalculationResult sliceResult;
 		assert((ScoreType)previousSlice.bandwidth < std::numeric_limits<ScoreType>::max());
@@ -600,9 +604,9 @@ private:
 	}
 
 	template <typename PriorityQueue>
-	DPSlice pickMethodAndExtendFill(const std::string_view& sequence, const DPSlice& previous, const std::vector<bool>& previousBand, std::vector<bool>& currentBand, std::vector<typename NodeSlice<LengthType, ScoreType, Word, true>::MapItem>& nodesliceMap, PriorityQueue& calculableQueue, int bandwidth, const std::vector<SeedHit>& seedHits, size_t seedhitStart, size_t seedhitEnd, const WordSlice extraSlice, std::vector<bool>& hasSeedStart, bool viterbi, bool storeNodeExactEndposScores) const
+	DPSlice pickMethodAndExtendFill(const std::string_view& sequence, const DPSlice& previous, const NodeBitvector& previousBand, NodeBitvector& currentBand, std::vector<typename NodeSlice<LengthType, ScoreType, Word, true>::MapItem>& nodesliceMap, PriorityQueue& calculableQueue, int bandwidth, const std::vector<SeedHit>& seedHits, size_t seedhitStart, size_t seedhitEnd, const WordSlice extraSlice, NodeBitvector& hasSeedStart, bool viterbi, bool storeNodeExactEndposScores) const
 	{
-		if (!params.lowMemory)
+		if (!params.lowMemory && nodesliceMap.size() > 0)
 		{
 			DPSlice bandTest { &nodesliceMap };
 			bandTest.j = previous.j + WordConfiguration<Word>::WordSize;
@@ -623,21 +627,154 @@ private:
 
 	DPTable getSlices(const std::string_view& sequence, const DPSlice& initialSlice, size_t numSlices, bool forceGlobal, int Xdropcutoff, AlignerGraphsizedState& reusableState) const
 	{
+		//a checkpointed table is on the heap, the arena would keep the dropped scores until the extension ends
+		DPArena::HeapScope heapScope { reusableState.maxTableMemory > 0 };
+		DPTable result;
 		if (Xdropcutoff > 0)
 		{
 			assert(!forceGlobal);
-			return getXdropSlices(sequence, initialSlice, numSlices, Xdropcutoff, reusableState);
+			result = getXdropSlices(sequence, initialSlice, numSlices, Xdropcutoff, reusableState);
 		}
 		else
 		{
-			return getViterbiSlices(sequence, initialSlice, numSlices, forceGlobal, reusableState);
+			result = getViterbiSlices(sequence, initialSlice, numSlices, forceGlobal, reusableState);
+		}
+		reusableState.counters.slices += result.slices.size();
+		if (result.checkpointStride > 1)
+		{
+			bool viterbi = Xdropcutoff <= 0;
+			result.recompute = [this, sequence, viterbi, &reusableState](DPTable& table, size_t index)
+			{
+				recomputeSlices(table, index, sequence, viterbi, reusableState);
+			};
+		}
+		return result;
+	}
+
+	static size_t storedSliceBytes(const DPSlice& slice)
+	{
+		if (slice.scoresDropped) return 0;
+		return slice.scores.size() * (sizeof(size_t) + sizeof(typename NodeSlice<LengthType, ScoreType, Word, false>::MapItem));
+	}
+
+	//called after a slice is added to the table. over half of the memory limit, thin the kept slices to every second one
+	//and keep doing so while they don't fit, so the slices with scores are spread evenly over the read
+	//the other half is for the slices the backtrace refills
+	void checkpointSlices(DPTable& table, size_t maxTableMemory) const
+	{
+		if (maxTableMemory == 0) return;
+		size_t last = table.slices.size()-1;
+		if (last % table.checkpointStride != 0)
+		{
+			table.slices[last].dropScores();
+			return;
+		}
+		table.storedBytes += storedSliceBytes(table.slices[last]);
+		while (table.storedBytes > maxTableMemory / 2 && table.checkpointStride < table.slices.size())
+		{
+			table.checkpointStride *= 2;
+			for (size_t i = 0; i < table.slices.size(); i++)
+			{
+				if (i % table.checkpointStride == 0 || table.slices[i].scoresDropped) continue;
+				table.storedBytes -= storedSliceBytes(table.slices[i]);
+				table.slices[i].dropScores();
+			}
+		}
+	}
+
+	void popSlice(DPTable& table) const
+	{
+		table.storedBytes -= storedSliceBytes(table.slices.back());
+		table.slices.pop_back();
+	}
+
+	void dropRestoredSlice(DPTable& table, size_t index) const
+	{
+		assert(index % table.checkpointStride != 0);
+		assert(!table.slices[index].scoresDropped);
+		table.restoredBytes -= storedSliceBytes(table.slices[index]);
+		table.slices[index].dropScores();
+	}
+
+	//refills the dropped slices from the closest slice with scores before index-1 up to index with the same fill as the forward pass
+	//the backtrace only moves backwards, so slices restored for it earlier which are past index+1 are dropped again
+	//over half of the memory limit the refilled slices are thinned like in checkpointSlices, and the ones kept are where later refills start
+	void recomputeSlices(DPTable& table, size_t index, const std::string_view& sequence, bool viterbi, AlignerGraphsizedState& reusableState) const
+	{
+		DPArena::HeapScope heapScope { true };
+		assert(index > 0);
+		assert(index < table.slices.size());
+		for (size_t i = index+2; i < table.slices.size(); i++)
+		{
+			if (i % table.checkpointStride != 0 && !table.slices[i].scoresDropped) dropRestoredSlice(table, i);
+		}
+		size_t start = index-1;
+		while (table.slices[start].scoresDropped)
+		{
+			assert(start > 0);
+			start -= 1;
 		}
+		size_t end = table.slices[index].scoresDropped ? index : index-1;
+		size_t checkpoint = (index-1) / table.checkpointStride * table.checkpointStride;
+		assert(checkpoint <= start);
+		DPSlice lastSlice = table.slices[start];
+		for (auto node : lastSlice.scores)
+		{
+			reusableState.previousBand[node.first] = true;
+		}
+		std::vector<SeedHit> fakeSeeds;
+		WordSlice fakeSlice { WordConfiguration<Word>::AllZeros, WordConfiguration<Word>::AllZeros, std::numeric_limits<ScoreType>::max() };
+		for (size_t i = start+1; i <= end; i++)
+		{
+			assert(table.slices[i].scoresDropped);
+			DPSlice newSlice;
+			if (reusableState.componentQueue.valid())
+			{
+				newSlice = pickMethodAndExtendFill(sequence, lastSlice, reusableState.previousBand, reusableState.currentBand, (i % 2 == 0) ? reusableState.evenNodesliceMap : reusableState.oddNodesliceMap, reusableState.componentQueue, table.slices[i].bandwidth, fakeSeeds, std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max(), fakeSlice, reusableState.hasSeedStart, viterbi, false);
+			}
+			else
+			{
+				newSlice = pickMethodAndExtendFill(sequence, lastSlice, reusableState.previousBand, reusableState.currentBand, (i % 2 == 0) ? reusableState.evenNodesliceMap : reusableState.oddNodesliceMap, reusableState.calculableQueue, table.slices[i].bandwidth, fakeSeeds, std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max(), fakeSlice, reusableState.hasSeedStart, viterbi, false);
+			}
+			assert(newSlice.j == table.slices[i].j);
+			assert(newSlice.minScore == table.slices[i].minScore);
+			//index and index-1 are needed by the backtrace right away, the others only if they are on the stride
+			if (i+1 >= index || i % table.restoreStride == 0)
+			{
+				table.slices[i].scores = newSlice.scores;
+				table.slices[i].scoresDropped = false;
+				table.restoredBytes += storedSliceBytes(table.slices[i]);
+			}
+			while (table.restoredBytes > reusableState.maxTableMemory / 2 && table.restoreStride < table.checkpointStride)
+			{
+				table.restoreStride *= 2;
+				for (size_t k = checkpoint+1; k < i && k+1 < index; k++)
+				{
+					if (k % table.restoreStride == 0 || table.slices[k].scoresDropped) continue;
+					dropRestoredSlice(table, k);
+				}
+			}
+			for (auto node : lastSlice.scores)
+			{
+				assert(reusableState.previousBand[node.first]);
+				reusableState.previousBand[node.first] = false;
+			}
+			std::swap(reusableState.previousBand, reusableState.currentBand);
+			lastSlice.scoresVectorMap.removeVectorArray();
+			lastSlice = std::move(newSlice);
+		}
+		for (auto node : lastSlice.scores)
+		{
+			assert(reusableState.previousBand[node.first]);
+			reusableState.previousBand[node.first] = false;
+		}
+		lastSlice.scoresVectorMap.removeVectorArray();
 	}
 
 	DPTable getViterbiSlices(const std::string_view& sequence, const DPSlice& initialSlice, size_t numSlices, bool forceGlobal, AlignerGraphsizedState& reusableState) const
 	{
-		assert(initialSlice.j == (size_t)-WordConfiguration<Word>::WordSize);
-		assert(initialSlice.j + numSlices * WordConfiguration<Word>::WordSize <= sequence.size() + WordConfiguration<Word>::WordSize);
+		assert(initialSlice.j == (LengthType)-WordConfiguration<Word>::WordSize);
+		assert((numSlices-1) * WordConfiguration<Word>::WordSize <= sequence.size() + WordConfiguration<Word>::WordSize);
 		DPTable result;
 		result.slices.reserve(numSlices + 1);
 		size_t cellsProcessed = 0;
@@ -746,6 +883,7 @@ private:
 					lastSlice.scoresVectorMap.removeVectorArray();
 					newSlice.scoresVectorMap.removeVectorArray();
 					rampUntil = slice;
+					reusableState.counters.bandRamps += 1;
 					std::swap(slice, rampRedoIndex);
 					std::swap(lastSlice, rampSlice);
 					for (auto node : lastSlice.scores)
@@ -756,8 +894,9 @@ private:
 					if (slice == (size_t)-1)
 					{
 						result.slices.clear();
+						result.storedBytes = 0;
 					}
-					while (result.slices.size() > 1 && result.slices.back().j > slice * WordConfiguration<Word>::WordSize) result.slices.pop_back();
+					while (result.slices.size() > 1 && result.slices.back().j > slice * WordConfiguration<Word>::WordSize) popSlice(result);
 					assert(slice == (size_t)-1 || result.slices.size() == slice+2);
 					assert(result.slices.back().j == lastSlice.j);
 #ifdef SLICEVERBOSE
@@ -775,6 +914,7 @@ private:
 #endif
 
 			result.slices.push_back(newSlice.getMapSlice());
+			checkpointSlices(result, reusableState.maxTableMemory);
 			for (auto node : lastSlice.scores)
 			{
 				assert(reusableState.previousBand[node.first]);
@@ -829,8 +969,8 @@ private:
 	DPTable getXdropSlices(const std::string_view& sequence, const DPSlice& initialSlice, size_t numSlices, double Xdropcutoff, AlignerGraphsizedState& reusableState) const
 	{
 		assert(params.preciseClipping);
-		assert(initialSlice.j == (size_t)-WordConfiguration<Word>::WordSize);
-		assert(initialSlice.j + numSlices * WordConfiguration<Word>::WordSize <= sequence.size() + WordConfiguration<Word>::WordSize);
+		assert(initialSlice.j == (LengthType)-WordConfiguration<Word>::WordSize);
+		assert((numSlices-1) * WordConfiguration<Word>::WordSize <= sequence.size() + WordConfiguration<Word>::WordSize);
 		DPTable result;
 		result.slices.reserve(numSlices + 1);
 		size_t cellsProcessed = 0;
@@ -923,6 +1063,7 @@ private:
 #endif
 
 			result.slices.push_back(newSlice.getMapSlice());
+			checkpointSlices(result, reusableState.maxTableMemory);
 			for (auto node : lastSlice.scores)
 			{
 				assert(reusableState.previousBand[node.first]);
@@ -978,9 +1119,10 @@ private:
 	{
 		assert(reusableState.componentQueue.valid());
 		assert(params.preciseClipping);
-		assert(initialSlice.j == (size_t)-WordConfiguration<Word>::WordSize);
-		assert(initialSlice.j + numSlices * WordConfiguration<Word>::WordSize <= sequence.size() + WordConfiguration<Word>::WordSize);
-		assert(initialSlice.j + (numSlices-1) * WordConfiguration<Word>::WordSize <= sequence.size());
+		//initial j is -WordSize, which doesn't survive widening to size_t with 32-bit LengthType
+		assert(initialSlice.j == (LengthType)-WordConfiguration<Word>::WordSize);
+		assert((numSlices-1) * WordConfiguration<Word>::WordSize <= sequence.size() + WordConfiguration<Word>::WordSize);
+		assert((numSlices-2) * WordConfiguration<Word>::WordSize <= sequence.size());
 		DPTable result;
 		result.slices.reserve(numSlices + 1);
 		size_t cellsProcessed = 0;
@@ -6,6 +6,7 @@
 #include <vector>
 #include <cmath>
 #include <iostream>
+#include <functional>
 #include "AlignmentGraph.h"
 #include "NodeSlice.h"
 #include "CommonUtils.h"
@@ -15,6 +16,7 @@
 #include "WordSlice.h"
 #include "GraphAlignerCommon.h"
 #include "ArrayPriorityQueue.h"
+#include "BitvectorSIMD.h"
 
 #ifndef NDEBUG
 thread_local int debugLastRowMinScore;
@@ -151,6 +153,7 @@ public:
 		cellsProcessed(0),
 		bandwidth(0),
 		scoresNotValid(false),
+		scoresDropped(false),
 		seedstartNodes()
 #ifdef SLICEVERBOSE
 		,nodesProcessed(0)
@@ -169,7 +172,8 @@ public:
 		j(std::numeric_limits<LengthType>::max()),
 		cellsProcessed(0),
 		bandwidth(0),
-		scoresNotValid(false)
+		scoresNotValid(false),
+		scoresDropped(false)
 #ifdef SLICEVERBOSE
 		,nodesProcessed(0)
 		,numCells(0)
@@ -187,8 +191,9 @@ public:
 		size_t cellsProcessed;
 		size_t bandwidth;
 		bool scoresNotValid;
-		std::unordered_set<size_t> seedstartNodes;
-		phmap::flat_hash_map<size_t, ScoreType> nodeMaxExactEndposScore;
+		bool scoresDropped;
+		ArenaHashSet<size_t> seedstartNodes;
+		ArenaHashMap<size_t, ScoreType> nodeMaxExactEndposScore;
 #ifdef SLICEVERBOSE
 		size_t nodesProcessed;
 		size_t numCells;
@@ -207,6 +212,7 @@ public:
 			result.cellsProcessed = cellsProcessed;
 			result.bandwidth = bandwidth;
 			result.scoresNotValid = scoresNotValid;
+			result.scoresDropped = scoresDropped;
 			result.seedstartNodes = seedstartNodes;
 			result.nodeMaxExactEndposScore = nodeMaxExactEndposScore;
 #ifdef SLICEVERBOSE
@@ -215,14 +221,35 @@ public:
 #endif
 			return result;
 		}
+		//keeps the rest of the slice so the table can still be searched for the backtrace start
+		void dropScores()
+		{
+			scores = NodeSlice<LengthType, ScoreType, Word, false>{};
+			seedstartNodes.clear();
+			nodeMaxExactEndposScore.clear();
+			scoresDropped = true;
+		}
 	};
 	class DPTable
 	{
 	public:
 		DPTable() :
-		slices()
+		slices(),
+		checkpointStride(1),
+		storedBytes(0),
+		restoreStride(1),
+		restoredBytes(0),
+		recompute()
 		{}
-		std::vector<DPSlice> slices;
+		ArenaVector<DPSlice> slices;
+		//over the memory limit only every checkpointStride'th slice keeps its scores
+		//the backtrace calls recompute(table, index) to refill index and index-1 from the checkpoint before them
+		//the refilled slices are thinned the same way with restoreStride so they fit in the limit too
+		size_t checkpointStride;
+		size_t storedBytes;
+		size_t restoreStride;
+		size_t restoredBytes;
+		std::function<void(DPTable&, size_t)> recompute;
 	};
 	class NodeCalculationResult
 	{
@@ -266,6 +293,40 @@ public:
 		return std::make_tuple(slice, Ph, Mh);
 	}
 
+	//independent columns which share the same Eq, eg. the incoming slices of a node
+	static void getNextSlices(Word Eq, WordSlice* slices, Word* hinP, Word* hinN, size_t count)
+	{
+		assert(count <= BitvectorSIMD::MaxLanes);
+#ifndef NOAVX2
+		if constexpr (std::is_same<Word, uint64_t>::value)
+		{
+			if (count >= BitvectorSIMD::MinLanes && BitvectorSIMD::hasAVX2)
+			{
+				uint64_t VP[BitvectorSIMD::MaxLanes] {};
+				uint64_t VN[BitvectorSIMD::MaxLanes] {};
+				for (size_t k = 0; k < count; k++)
+				{
+					VP[k] = slices[k].VP;
+					VN[k] = slices[k].VN;
+				}
+				BitvectorSIMD::nextSlicesAVX2(Eq, VP, VN, hinP, hinN);
+				for (size_t k = 0; k < count; k++)
+				{
+					slices[k].VP = VP[k];
+					slices[k].VN = VN[k];
+					slices[k].scoreEnd -= hinN[k];
+					slices[k].scoreEnd += hinP[k];
+				}
+				return;
+			}
+		}
+#endif
+		for (size_t k = 0; k < count; k++)
+		{
+			std::tie(slices[k], hinP[k], hinN[k]) = getNextSlice(Eq, slices[k], hinP[k], hinN[k]);
+		}
+	}
+
 	static WordSlice flattenWordSlice(WordSlice slice, size_t row)
 	{
 		Word mask = ~(WordConfiguration<Word>::AllOnes << row);
@@ -357,7 +418,7 @@ public:
 		return result;
 	}
 
-	static std::vector<OnewayTrace> getLocalMaximaTracesFromTable(const Params& params, const std::string_view& sequence, const DPTable& slice, AlignerGraphsizedState& reusableState, bool sliceConsistency, bool multiseed)
+	static std::vector<OnewayTrace> getLocalMaximaTracesFromTable(const Params& params, const std::string_view& sequence, DPTable& slice, AlignerGraphsizedState& reusableState, bool sliceConsistency, bool multiseed)
 	{
 		std::vector<OnewayTrace> result;
 		assert(slice.slices.size() > 1);
@@ -498,7 +559,7 @@ public:
 		return result;
 	}
 
-	static OnewayTrace getReverseTraceFromTableExactEndPos(const Params& params, const std::string_view& sequence, const DPTable& slice, AlignerGraphsizedState& reusableState, bool sliceConsistency, bool multiseed)
+	static OnewayTrace getReverseTraceFromTableExactEndPos(const Params& params, const std::string_view& sequence, DPTable& slice, AlignerGraphsizedState& reusableState, bool sliceConsistency, bool multiseed)
 	{
 		assert(slice.slices.size() > 1);
 		size_t bestIndex = 1;
@@ -513,6 +574,7 @@ public:
 		}
 		auto node = slice.slices[bestIndex].maxExactEndposNode;
 		auto score = slice.slices[bestIndex].maxExactEndposScore;
+		restoreSlices(slice, bestIndex);
 		typename NodeSlice<LengthType, ScoreType, Word, false>::NodeSliceMapItem previous;
 		if (slice.slices[bestIndex-1].scores.hasNode(node))
 		{
@@ -566,15 +628,16 @@ public:
 		return getReverseTraceFromTable(params, sequence, slice, reusableState, startPos, startScore, sliceConsistency, multiseed);
 	}
 
-	static OnewayTrace getReverseTraceFromTableStartLastRow(const Params& params, const std::string_view& sequence, const DPTable& slice, AlignerGraphsizedState& reusableState, bool sliceConsistency, bool multiseed)
+	static OnewayTrace getReverseTraceFromTableStartLastRow(const Params& params, const std::string_view& sequence, DPTable& slice, AlignerGraphsizedState& reusableState, bool sliceConsistency, bool multiseed)
 	{
 		ScoreType startScore = slice.slices.back().minScore;
-		MatrixPosition startPos {slice.slices.back().minScoreNode, slice.slices.back().minScoreNodeOffset, std::min(slice.slices.back().j + WordConfiguration<Word>::WordSize - 1, sequence.size()-1)};
+		MatrixPosition startPos {slice.slices.back().minScoreNode, slice.slices.back().minScoreNodeOffset, std::min((size_t)slice.slices.back().j + WordConfiguration<Word>::WordSize - 1, sequence.size()-1)};
 		return getReverseTraceFromTable(params, sequence, slice, reusableState, startPos, startScore, sliceConsistency, multiseed);
 	}
 
-	static OnewayTrace getReverseTraceFromTable(const Params& params, const std::string_view& sequence, const DPTable& slice, AlignerGraphsizedState& reusableState, MatrixPosition startPos, ScoreType startScore, bool sliceConsistency, bool multiseed)
+	static OnewayTrace getReverseTraceFromTable(const Params& params, const std::string_view& sequence, DPTable& slice, AlignerGraphsizedState& reusableState, MatrixPosition startPos, ScoreType startScore, bool sliceConsistency, bool multiseed)
 	{
+		ReadMetrics::ScopedTimer backtraceTimer { reusableState.counters.backtraceMicroseconds };
 		assert(slice.slices.size() > 0);
 		size_t currentSlice = startPos.seqPos / WordConfiguration<Word>::WordSize + 1;
 		assert(currentSlice < slice.slices.size());
@@ -600,8 +663,9 @@ public:
 				if (newSlice != currentSlice) EqV = getEqVector(sequence, slice.slices[newSlice].j);
 				currentSlice = newSlice;
 				currentNode = newNode;
-				assert(slice.slices[currentSlice].scores.hasNode(currentNode));
 				assert(currentSlice > 0);
+				restoreSlices(slice, currentSlice);
+				assert(slice.slices[currentSlice].scores.hasNode(currentNode));
 				typename NodeSlice<LengthType, ScoreType, Word, false>::NodeSliceMapItem previous;
 				if (slice.slices[currentSlice-1].scores.hasNode(currentNode))
 				{
@@ -762,6 +826,18 @@ public:
 		return result;
 	}
 
+	//makes sure slices index and index-1 have their scores, checkpointing might have dropped them
+	static void restoreSlices(DPTable& table, size_t index)
+	{
+		assert(index > 0);
+		assert(index < table.slices.size());
+		if (!table.slices[index].scoresDropped && !table.slices[index-1].scoresDropped) return;
+		assert(table.recompute);
+		table.recompute(table, index);
+		assert(!table.slices[index].scoresDropped);
+		assert(!table.slices[index-1].scoresDropped);
+	}
+
 	static void checkBacktraceCircularity(const OnewayTrace& result)
 	{
 		for (size_t i = result.trace.size()-2; i < result.trace.size(); i--)
@@ -1110,7 +1186,7 @@ public:
 #ifdef NDEBUG
 	__attribute__((always_inline))
 #endif
-	static NodeCalculationResult calculateNodeClipPrecise(const Params& params, size_t i, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem& slice, const EqVector& EqV, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem previousSlice, const std::vector<EdgeWithPriority>& incoming, const std::vector<bool>& previousBand, NodeChunkType nodeChunks, const WordSlice extraSlice, ScoreType seqOffset)
+	static NodeCalculationResult calculateNodeClipPrecise(const Params& params, size_t i, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem& slice, const EqVector& EqV, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem previousSlice, const std::vector<EdgeWithPriority>& incoming, const NodeBitvector& previousBand, NodeChunkType nodeChunks, const WordSlice extraSlice, ScoreType seqOffset)
 	{
 		return calculateNodeInner<true, true>(params, i, slice, EqV, previousSlice, incoming, [&previousBand](size_t pos) { return previousBand[pos]; }, nodeChunks, extraSlice, [](const WordSlice& slice){}, seqOffset);
 	}
@@ -1119,7 +1195,7 @@ public:
 #ifdef NDEBUG
 	__attribute__((always_inline))
 #endif
-	static NodeCalculationResult calculateNodeClipApprox(const Params& params, size_t i, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem& slice, const EqVector& EqV, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem previousSlice, const std::vector<EdgeWithPriority>& incoming, const std::vector<bool>& previousBand, NodeChunkType nodeChunks, const WordSlice extraSlice, ScoreType seqOffset)
+	static NodeCalculationResult calculateNodeClipApprox(const Params& params, size_t i, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem& slice, const EqVector& EqV, typename NodeSlice<LengthType, ScoreType, Word, true>::NodeSliceMapItem previousSlice, const std::vector<EdgeWithPriority>& incoming, const NodeBitvector& previousBand, NodeChunkType nodeChunks, const WordSlice extraSlice, ScoreType seqOffset)
 	{
 		return calculateNodeInner<false, true>(params, i, slice, EqV, previousSlice, incoming, [&previousBand](size_t pos) { return previousBand[pos]; }, nodeChunks, extraSlice, [](const WordSlice& slice){}, seqOffset);
 	}
@@ -1156,6 +1232,35 @@ public:
 		bool hasSkipless = false;
 		bool forceCalculation = false;
 
+		//the skipless incoming slices are calculated in batches so getNextSlices can put them in separate lanes
+		WordSlice pendingSlices[BitvectorSIMD::MaxLanes];
+		Word pendingHinP[BitvectorSIMD::MaxLanes] {};
+		Word pendingHinN[BitvectorSIMD::MaxLanes] {};
+		size_t numPending = 0;
+		auto mergePending = [&]()
+		{
+			getNextSlices(Eq, pendingSlices, pendingHinP, pendingHinN, numPending);
+			for (size_t k = 0; k < numPending; k++)
+			{
+				WordSlice newWs = pendingSlices[k];
+				if (!previousSlice.exists || newWs.getScoreBeforeStart() < previousSlice.startSlice.scoreEnd)
+				{
+					newWs.VP &= WordConfiguration<Word>::AllOnes ^ 1;
+					newWs.VN |= 1;
+				}
+				if (!hasWs)
+				{
+					ws = newWs;
+					hasWs = true;
+				}
+				else
+				{
+					ws = ws.mergeWith(newWs);
+				}
+			}
+			numPending = 0;
+		};
+
 		for (auto inc : incoming)
 		{
 			result.cellsProcessed++;
@@ -1202,24 +1307,13 @@ public:
 				hinN = 0;
 			}
 
-			WordSlice newWs;
-			std::tie(newWs, hinP, hinN) = getNextSlice(Eq, inc.incoming, hinP, hinN);
-			if (!previousSlice.exists || newWs.getScoreBeforeStart() < previousSlice.startSlice.scoreEnd)
-			{
-				newWs.VP &= WordConfiguration<Word>::AllOnes ^ 1;
-				newWs.VN |= 1;
-			}
-			// assert(newWs.getScoreBeforeStart() >= debugLastRowMinScore || newWs.getScoreBeforeStart() >= extraSlice.getScoreBeforeStart());
-			if (!hasWs)
-			{
-				ws = newWs;
-				hasWs = true;
-			}
-			else
-			{
-				ws = ws.mergeWith(newWs);
-			}
+			pendingSlices[numPending] = inc.incoming;
+			pendingHinP[numPending] = hinP;
+			pendingHinN[numPending] = hinN;
+			numPending += 1;
+			if (numPending == BitvectorSIMD::MaxLanes) mergePending();
 		}
+		mergePending();
 
 		assert(hasWs);
 
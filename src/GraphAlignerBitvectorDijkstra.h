@@ -1,6 +1,8 @@
 #ifndef GraphAlignerBitvectorDijkstra_h
 #define GraphAlignerBitvectorDijkstra_h
 
+#include "SeedHeuristic.h"
+
 template <typename LengthType, typename ScoreType, typename Word>
 class GraphAlignerBitvectorDijkstra
 {
@@ -53,9 +55,11 @@ public:
 	// 	return result;
 	// }
 
-	OnewayTrace getBacktraceFullStart(const std::string_view& originalSequence, bool forceGlobal, AlignerGraphsizedState& reusableState) const
+	//with heuristicKmerLength > 0 the search is guided by the absent k-mers of the read, see SeedHeuristic.h. the result is still optimal
+	OnewayTrace getBacktraceFullStart(const std::string_view& originalSequence, bool forceGlobal, AlignerGraphsizedState& reusableState, size_t heuristicKmerLength) const
 	{
 		assert(originalSequence.size() > 1);
+		DPArena::Scope arenaScope { reusableState.arena };
 		std::string_view alignableSequence { originalSequence.data()+1, originalSequence.size() - 1 };
 		assert(alignableSequence.size() > 0);
 		size_t numSlices = (alignableSequence.size() + WordConfiguration<Word>::WordSize - 1) / WordConfiguration<Word>::WordSize;
@@ -111,7 +115,8 @@ public:
 			table.slices[i].minScoreNode = 0;
 			table.slices[i].minScoreNodeOffset = 0;
 		}
-		fillTable(table, alignableSequence, reusableState);
+		fillTable(table, alignableSequence, reusableState, heuristicKmerLength);
+		reusableState.counters.slices += table.slices.size();
 		if (!params.preciseClipping && !forceGlobal) BV::removeWronglyAlignedEnd(table);
 		if (table.slices.size() <= 1)
 		{
@@ -139,7 +144,7 @@ public:
 
 private:
 
-	void fillTable(DPTable& table, const std::string_view& sequence, AlignerGraphsizedState& reusableState) const
+	void fillTable(DPTable& table, const std::string_view& sequence, AlignerGraphsizedState& reusableState, size_t heuristicKmerLength) const
 	{
 		assert(!params.preciseClipping);
 		assert(reusableState.dijkstraQueue.size() == 0);
@@ -164,6 +169,26 @@ private:
 		{
 			EqV.emplace_back(BV::getEqVector(sequence, i * WordConfiguration<Word>::WordSize));
 		}
+		//A*: the queue is ordered by score plus a lower bound of the cost of the read after the slice
+		//the bound is subtracted from its value at the start so the priorities start from zero, and that's stored as the discount of each slice
+		std::vector<size_t> discount;
+		discount.resize(numSlices+1, 0);
+		if (heuristicKmerLength > 0)
+		{
+			std::vector<size_t> absentAfter = SeedHeuristic::getAbsentKmersAfter(params.graph, sequence, heuristicKmerLength);
+			for (size_t i = 0; i <= numSlices; i++)
+			{
+				discount[i] = absentAfter[std::min<size_t>(sequence.size(), WordConfiguration<Word>::WordSize)] - absentAfter[std::min<size_t>(sequence.size(), (i+1) * WordConfiguration<Word>::WordSize)];
+			}
+		}
+		//an item is reached from the one being processed so that one's bound holds for it too,
+		//so the priority never drops below the current one (pathmax) and the bucket queue stays monotonic
+		auto priority = [&discount, &zeroScore](ScoreType score, size_t slice) -> size_t
+		{
+			assert(discount[slice] > 0 || (size_t)score >= zeroScore);
+			if ((size_t)score < zeroScore + discount[slice]) return zeroScore;
+			return score - discount[slice];
+		};
 		size_t lastRowScore = std::numeric_limits<size_t>::max();
 		assert(reusableState.dijkstraQueue.zero() == 0);
 		WordSlice fakeSlice { WordConfiguration<Word>::AllZeros, WordConfiguration<Word>::AllZeros, std::numeric_limits<ScoreType>::max() };
@@ -182,7 +207,7 @@ private:
 				reusableState.dijkstraQueue.increaseScore(edge.priority - zeroScore);
 				zeroScore = edge.priority;
 			}
-			if (zeroScore >= lastRowScore) break;
+			if (zeroScore + discount.back() >= lastRowScore) break;
 			size_t tableSlice = edge.slice+1;
 			assert(tableSlice > 0);
 			assert(tableSlice <= numSlices);
@@ -194,7 +219,7 @@ private:
 			if (!table.slices[tableSlice].scores.hasNode(i))
 			{
 				table.slices[tableSlice].scores.addNodeToMap(i);
-				table.slices[tableSlice].scores.setMinScore(i, zeroScore + 64);
+				table.slices[tableSlice].scores.setMinScore(i, zeroScore + discount[slice] + WordConfiguration<Word>::WordSize);
 			}
 			auto& thisNode = table.slices[tableSlice].scores.node(i);
 			auto oldEnd = thisNode.endSlice;
@@ -241,7 +266,7 @@ private:
 			}
 			reusableState.dijkstraQueue.pop();
 			reusableState.dijkstraQueue.removeExtras(slice, i);
-			assert(nodeCalc.minScore <= zeroScore + params.graph.SPLIT_NODE_SIZE + WordConfiguration<Word>::WordSize);
+			assert(nodeCalc.minScore <= zeroScore + discount[slice] + params.graph.SPLIT_NODE_SIZE + WordConfiguration<Word>::WordSize);
 			table.slices[tableSlice].scores.setMinScoreIfSmaller(i, nodeCalc.minScore);
 #ifdef SLICEVERBOSE
 			volatile size_t firstslices = table.slices[tableSlice].scores.node(i).firstSlicesCalcedWhenCalced;
@@ -258,28 +283,28 @@ private:
 			if (newEnd.scoreEnd != oldEnd.scoreEnd || newHP != oldHP || newHN != oldHN)
 			{
 				ScoreType newEndMinScore = changedHorizontal(newEnd, newHP, newHN, oldEnd, oldHP, oldHN, params.graph.NodeLength(i));
-				assert(newEndMinScore >= zeroScore);
 				assert(newEndMinScore != std::numeric_limits<ScoreType>::max());
-				reusableState.dijkstraQueue.insert(newEndMinScore, EdgeWithPriority { i, newEndMinScore, BV::getSourceSliceFromScore(thisNode.startSlice.scoreEnd), true, slice+1 });
+				size_t newPriority = priority(newEndMinScore, slice+1);
+				reusableState.dijkstraQueue.insert(newPriority, EdgeWithPriority { i, (int)newPriority, BV::getSourceSliceFromScore(thisNode.startSlice.scoreEnd), true, slice+1 });
 			}
 			if (newEnd.scoreEnd != oldEnd.scoreEnd)
 			{
 				ScoreType newEndMinScore = newEnd.scoreEnd;
-				assert(newEndMinScore >= zeroScore);
 				assert(newEndMinScore != std::numeric_limits<ScoreType>::max());
+				size_t newPriority = priority(newEndMinScore, slice+1);
 				for (auto neighbor : params.graph.outNeighbors[i])
 				{
-					reusableState.dijkstraQueue.insert(newEndMinScore, EdgeWithPriority { neighbor, newEndMinScore, BV::getSourceSliceFromScore(newEnd.scoreEnd), false, slice+1 });
+					reusableState.dijkstraQueue.insert(newPriority, EdgeWithPriority { neighbor, (int)newPriority, BV::getSourceSliceFromScore(newEnd.scoreEnd), false, slice+1 });
 				}
 			}
 			if (newEnd.scoreEnd != oldEnd.scoreEnd || newEnd.VP != oldEnd.VP || newEnd.VN != oldEnd.VN)
 			{
 				ScoreType newEndMinScore = newEnd.changedMinScore(oldEnd);
-				assert(newEndMinScore >= zeroScore);
 				assert(newEndMinScore != std::numeric_limits<ScoreType>::max());
+				size_t newPriority = priority(newEndMinScore, slice);
 				for (auto neighbor : params.graph.outNeighbors[i])
 				{
-					reusableState.dijkstraQueue.insert(newEndMinScore, EdgeWithPriority { neighbor, newEndMinScore, newEnd, false, slice });
+					reusableState.dijkstraQueue.insert(newPriority, EdgeWithPriority { neighbor, (int)newPriority, newEnd, false, slice });
 				}
 			}
 			table.slices[tableSlice].cellsProcessed += nodeCalc.cellsProcessed;
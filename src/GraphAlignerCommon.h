@@ -1,13 +1,92 @@
 #ifndef GraphAlignerCommon_h
 #define GraphAlignerCommon_h
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <tuple>
 #include <vector>
 #include "AlignmentGraph.h"
 #include "ArrayPriorityQueue.h"
 #include "ComponentPriorityQueue.h"
+#include "NodeBitvector.h"
 #include "NodeSlice.h"
+#include "DPArena.h"
 #include "WordSlice.h"
 #include "DijkstraQueue.h"
+#include "ReadMetrics.h"
+
+//traces don't depend on the word size so aligners with different word sizes return the same traces
+template <typename ScoreType>
+class GraphAlignerTraceTypes
+{
+public:
+	using MatrixPosition = AlignmentGraph::MatrixPosition;
+	struct TraceItem
+	{
+		TraceItem() :
+		DPposition(),
+		nodeSwitch(false),
+		sequenceCharacter('-'),
+		graphCharacter('-')
+		{}
+		TraceItem(MatrixPosition DPposition, bool nodeSwitch, char sequenceCharacter, char graphCharacter) :
+		DPposition(DPposition),
+		nodeSwitch(nodeSwitch),
+		sequenceCharacter(sequenceCharacter),
+		graphCharacter(graphCharacter)
+		{}
+		TraceItem(MatrixPosition DPposition, bool nodeSwitch, const std::string& seq, const AlignmentGraph& graph) :
+		DPposition(DPposition),
+		nodeSwitch(nodeSwitch),
+		sequenceCharacter(DPposition.seqPos < seq.size() ? seq[DPposition.seqPos] : '-'),
+		graphCharacter(graph.NodeSequences(DPposition.node, DPposition.nodeOffset))
+		{}
+		TraceItem(MatrixPosition DPposition, bool nodeSwitch, const std::string_view& seq, const AlignmentGraph& graph) :
+		DPposition(DPposition),
+		nodeSwitch(nodeSwitch),
+		sequenceCharacter(DPposition.seqPos < seq.size() ? seq[DPposition.seqPos] : '-'),
+		graphCharacter(graph.NodeSequences(DPposition.node, DPposition.nodeOffset))
+		{}
+		MatrixPosition DPposition;
+		bool nodeSwitch;
+		char sequenceCharacter;
+		char graphCharacter;
+	};
+	class OnewayTrace
+	{
+	public:
+		OnewayTrace() :
+		trace(),
+		score(0)
+		{
+		}
+		// force move semantics because copying is very slow and unnecessary
+		OnewayTrace(const OnewayTrace& other) = delete;
+		OnewayTrace(OnewayTrace&& other) = default;
+		OnewayTrace& operator=(const OnewayTrace& other) = delete;
+		OnewayTrace& operator=(OnewayTrace&& other) = default;
+		static OnewayTrace TraceFailed()
+		{
+			OnewayTrace result;
+			result.score = std::numeric_limits<ScoreType>::max();
+			return result;
+		}
+		bool failed() const
+		{
+			return score == std::numeric_limits<ScoreType>::max();
+		}
+		std::vector<TraceItem> trace;
+		ScoreType score;
+	};
+	class Trace
+	{
+	public:
+		OnewayTrace forward;
+		OnewayTrace backward;
+	};
+};
 
 template <typename LengthType, typename ScoreType, typename Word>
 class GraphAlignerCommon
@@ -16,7 +95,7 @@ public:
 	class NodeWithPriority
 	{
 	public:
-		NodeWithPriority(LengthType node, size_t offset, size_t endOffset, int priority) : node(node), offset(offset), endOffset(endOffset), priority(priority) {}
+		NodeWithPriority(size_t node, size_t offset, size_t endOffset, int priority) : node(node), offset(offset), endOffset(endOffset), priority(priority) {}
 		bool operator>(const NodeWithPriority& other) const
 		{
 		return priority > other.priority;
@@ -33,8 +112,8 @@ public:
 	class EdgeWithPriority
 	{
 	public:
-		EdgeWithPriority(LengthType target, int priority, WordSlice<LengthType, ScoreType, Word> incoming, bool skipFirst) : target(target), priority(priority), incoming(incoming), skipFirst(skipFirst), slice(0), forceCalculation(false) {}
-		EdgeWithPriority(LengthType target, int priority, WordSlice<LengthType, ScoreType, Word> incoming, bool skipFirst, size_t slice) : target(target), priority(priority), incoming(incoming), skipFirst(skipFirst), slice(slice), forceCalculation(false) {}
+		EdgeWithPriority(size_t target, int priority, WordSlice<LengthType, ScoreType, Word> incoming, bool skipFirst) : target(target), priority(priority), incoming(incoming), skipFirst(skipFirst), slice(0), forceCalculation(false) {}
+		EdgeWithPriority(size_t target, int priority, WordSlice<LengthType, ScoreType, Word> incoming, bool skipFirst, size_t slice) : target(target), priority(priority), incoming(incoming), skipFirst(skipFirst), slice(slice), forceCalculation(false) {}
 		bool operator>(const EdgeWithPriority& other) const
 		{
 			return priority > other.priority;
@@ -53,25 +132,30 @@ public:
 	class AlignerGraphsizedState
 	{
 	public:
-		AlignerGraphsizedState(const AlignmentGraph& graph, size_t maxBandwidth, bool lowMemory) :
+		//sparse state keeps the per node bits in hash sets and forces low memory nodeslices, so its size follows the band instead of the graph
+		//maxTableMemory limits the scores kept for the backtrace in bytes, past it the DP table is checkpointed. 0 is no limit
+		AlignerGraphsizedState(const AlignmentGraph& graph, size_t maxBandwidth, bool lowMemory, bool sparse = false, size_t maxTableMemory = 0) :
 		componentQueue(),
 		calculableQueue(),
 		evenNodesliceMap(),
 		oddNodesliceMap(),
 		currentBand(),
 		previousBand(),
-		hasSeedStart()
+		hasSeedStart(),
+		counters(),
+		arena(),
+		maxTableMemory(maxTableMemory)
 		{
-			if (!lowMemory)
+			if (!lowMemory && !sparse)
 			{
 				evenNodesliceMap.resize(graph.NodeSize(), {});
 				oddNodesliceMap.resize(graph.NodeSize(), {});
 			}
-			componentQueue.initialize(graph.ComponentSize());
+			componentQueue.initialize(graph.ComponentSize(), sparse);
 			calculableQueue.initialize(WordConfiguration<Word>::WordSize * (WordConfiguration<Word>::WordSize + maxBandwidth + 1) + maxBandwidth + 1, graph.NodeSize());
-			currentBand.resize(graph.NodeSize(), false);
-			previousBand.resize(graph.NodeSize(), false);
-			hasSeedStart.resize(graph.NodeSize(), false);
+			currentBand.resize(graph.NodeSize(), sparse);
+			previousBand.resize(graph.NodeSize(), sparse);
+			hasSeedStart.resize(graph.NodeSize(), sparse);
 		}
 		void clear()
 		{
@@ -80,24 +164,30 @@ public:
 			componentQueue.clear();
 			calculableQueue.clear();
 			dijkstraQueue.clear();
-			currentBand.assign(currentBand.size(), false);
-			previousBand.assign(previousBand.size(), false);
-			hasSeedStart.assign(hasSeedStart.size(), false);
+			currentBand.clear();
+			previousBand.clear();
+			hasSeedStart.clear();
+			counters.clear();
+			arena.clear();
 		}
 		ComponentPriorityQueue<EdgeWithPriority, true> componentQueue;
 		ArrayPriorityQueue<EdgeWithPriority, true> calculableQueue;
 		DijkstraPriorityQueue<EdgeWithPriority> dijkstraQueue;
 		std::vector<typename NodeSlice<LengthType, ScoreType, Word, true>::MapItem> evenNodesliceMap;
 		std::vector<typename NodeSlice<LengthType, ScoreType, Word, true>::MapItem> oddNodesliceMap;
-		std::vector<bool> currentBand;
-		std::vector<bool> previousBand;
-		std::vector<bool> hasSeedStart;
+		NodeBitvector currentBand;
+		NodeBitvector previousBand;
+		NodeBitvector hasSeedStart;
+		ReadMetrics::AlignerCounters counters;
+		//backs the DP tables, see DPArena.h
+		DPArena arena;
+		size_t maxTableMemory;
 	};
 	using MatrixPosition = AlignmentGraph::MatrixPosition;
 	class Params
 	{
 	public:
-		Params(LengthType initialBandwidth, LengthType rampBandwidth, const AlignmentGraph& graph, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minSeedClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, double multimapScoreFraction) :
+		Params(size_t initialBandwidth, size_t rampBandwidth, const AlignmentGraph& graph, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minSeedClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, double multimapScoreFraction) :
 		initialBandwidth(initialBandwidth),
 		rampBandwidth(rampBandwidth),
 		graph(graph),
@@ -131,69 +221,9 @@ public:
 		const int Xdropcutoff;
 		const double multimapScoreFraction;
 	};
-	struct TraceItem
-	{
-		TraceItem() :
-		DPposition(),
-		nodeSwitch(false),
-		sequenceCharacter('-'),
-		graphCharacter('-')
-		{}
-		TraceItem(MatrixPosition DPposition, bool nodeSwitch, char sequenceCharacter, char graphCharacter) :
-		DPposition(DPposition),
-		nodeSwitch(nodeSwitch),
-		sequenceCharacter(sequenceCharacter),
-		graphCharacter(graphCharacter)
-		{}
-		TraceItem(MatrixPosition DPposition, bool nodeSwitch, const std::string& seq, const AlignmentGraph& graph) :
-		DPposition(DPposition),
-		nodeSwitch(nodeSwitch),
-		sequenceCharacter(DPposition.seqPos < seq.size() ? seq[DPposition.seqPos] : '-'),
-		graphCharacter(graph.NodeSequences(DPposition.node, DPposition.nodeOffset))
-		{}
-		TraceItem(MatrixPosition DPposition, bool nodeSwitch, const std::string_view& seq, const AlignmentGraph& graph) :
-		DPposition(DPposition),
-		nodeSwitch(nodeSwitch),
-		sequenceCharacter(DPposition.seqPos < seq.size() ? seq[DPposition.seqPos] : '-'),
-		graphCharacter(graph.NodeSequences(DPposition.node, DPposition.nodeOffset))
-		{}
-		MatrixPosition DPposition;
-		bool nodeSwitch;
-		char sequenceCharacter;
-		char graphCharacter;
-	};
-	class OnewayTrace
-	{
-	public:
-		OnewayTrace() :
-		trace(),
-		score(0)
-		{
-		}
-		// force move semantics because copying is very slow and unnecessary
-		OnewayTrace(const OnewayTrace& other) = delete;
-		OnewayTrace(OnewayTrace&& other) = default;
-		OnewayTrace& operator=(const OnewayTrace& other) = delete;
-		OnewayTrace& operator=(OnewayTrace&& other) = default;
-		static OnewayTrace TraceFailed()
-		{
-			OnewayTrace result;
-			result.score = std::numeric_limits<ScoreType>::max();
-			return result;
-		}
-		bool failed() const
-		{
-			return score == std::numeric_limits<ScoreType>::max();
-		}
-		std::vector<TraceItem> trace;
-		ScoreType score;
-	};
-	class Trace
-	{
-	public:
-		OnewayTrace forward;
-		OnewayTrace backward;
-	};
+	using TraceItem = typename GraphAlignerTraceTypes<ScoreType>::TraceItem;
+	using OnewayTrace = typename GraphAlignerTraceTypes<ScoreType>::OnewayTrace;
+	using Trace = typename GraphAlignerTraceTypes<ScoreType>::Trace;
 #ifdef NDEBUG
 	__attribute__((always_inline))
 #endif
@@ -303,6 +333,188 @@ public:
 	}
 };
 
+//the path of a finished alignment as runs of edit operations on each visited node, instead of one TraceItem per DP cell
+//positions are in the original graph's nodes like in the fixed traces
+class CompactTrace
+{
+public:
+	enum EditType : uint8_t
+	{
+		Match,
+		Mismatch,
+		Insertion,
+		Deletion
+	};
+	class EditRun
+	{
+	public:
+		uint32_t length;
+		EditType type;
+	};
+	class NodeVisit
+	{
+	public:
+		int nodeId;
+		size_t startOffset;
+		size_t endOffset;
+		//sequence position of the first cell on this visit
+		size_t seqPos;
+		//edit runs [previous visit's editsEnd, editsEnd) are on this visit
+		size_t editsEnd;
+	};
+	CompactTrace() :
+	nodes(),
+	edits(),
+	seqStart(0),
+	seqEnd(0),
+	numCells(0),
+	score(0)
+	{
+	}
+	//same edits as the GAF and GAM output derived from the per cell trace
+	template <typename TraceItem>
+	CompactTrace(const std::vector<TraceItem>& trace, int32_t score) :
+	nodes(),
+	edits(),
+	seqStart(0),
+	seqEnd(0),
+	numCells(trace.size()),
+	score(score)
+	{
+		if (trace.size() == 0) return;
+		seqStart = trace[0].DPposition.seqPos;
+		seqEnd = trace.back().DPposition.seqPos + 1;
+		nodes.push_back(NodeVisit { (int)trace[0].DPposition.node, trace[0].DPposition.nodeOffset, trace[0].DPposition.nodeOffset, trace[0].DPposition.seqPos, 0 });
+		addEdit(characterMatch(trace[0].sequenceCharacter, trace[0].graphCharacter) ? Match : Mismatch, 0);
+		size_t visitEditsStart = 0;
+		for (size_t i = 1; i < trace.size(); i++)
+		{
+			const auto& oldPos = trace[i-1].DPposition;
+			const auto& newPos = trace[i].DPposition;
+			assert(newPos.seqPos == oldPos.seqPos || newPos.seqPos == oldPos.seqPos+1);
+			bool insideNode = !trace[i-1].nodeSwitch || ((int)newPos.node == nodes.back().nodeId && newPos.nodeOffset > nodes.back().startOffset);
+			EditType type;
+			if (oldPos.seqPos == newPos.seqPos)
+			{
+				type = Deletion;
+			}
+			else if (insideNode && oldPos.nodeOffset == newPos.nodeOffset)
+			{
+				type = Insertion;
+			}
+			else
+			{
+				type = characterMatch(trace[i].sequenceCharacter, trace[i].graphCharacter) ? Match : Mismatch;
+			}
+			//a wrap around a looping node stays on the same node but can't be described as one continuous visit
+			if (insideNode && newPos.nodeOffset != oldPos.nodeOffset + (type == Insertion ? 0 : 1)) insideNode = false;
+			if (!insideNode)
+			{
+				nodes.back().editsEnd = edits.size();
+				visitEditsStart = edits.size();
+				nodes.push_back(NodeVisit { (int)newPos.node, newPos.nodeOffset, newPos.nodeOffset, newPos.seqPos, 0 });
+			}
+			nodes.back().endOffset = newPos.nodeOffset;
+			addEdit(type, visitEditsStart);
+		}
+		nodes.back().editsEnd = edits.size();
+		edits.shrink_to_fit();
+		nodes.shrink_to_fit();
+	}
+	size_t editsStart(size_t visit) const
+	{
+		return visit == 0 ? 0 : nodes[visit-1].editsEnd;
+	}
+	//calls f(visitIndex, run, seqPos, nodeOffset) for every edit run in order with the position of the run's first cell
+	//the other cells of the run follow by moving forward in the sequence unless deleting and in the node unless inserting
+	template <typename F>
+	void forEachRun(F f) const
+	{
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			forEachRunInVisit(i, f);
+		}
+	}
+	//calls f(seqPos, nodeId, nodeOffset, type) for every cell in order
+	template <typename F>
+	void forEachCell(F f) const
+	{
+		forEachRun([this, f](size_t visit, const EditRun& run, size_t seqPos, size_t nodeOffset)
+		{
+			for (size_t i = 0; i < run.length; i++)
+			{
+				f(seqPos + (run.type != Deletion ? i : 0), nodes[visit].nodeId, nodeOffset + (run.type != Insertion ? i : 0), run.type);
+			}
+		});
+	}
+	bool containsCell(size_t seqPos, int nodeId, size_t nodeOffset) const
+	{
+		if (seqPos < seqStart || seqPos >= seqEnd) return false;
+		//deletions can put the cells of one sequence position on several visits
+		size_t visit = std::upper_bound(nodes.begin(), nodes.end(), seqPos, [](size_t pos, const NodeVisit& visit) { return pos < visit.seqPos; }) - nodes.begin();
+		assert(visit > 0);
+		visit -= 1;
+		while (visit > 0 && nodes[visit].seqPos == seqPos) visit -= 1;
+		bool found = false;
+		for (; visit < nodes.size() && nodes[visit].seqPos <= seqPos && !found; visit++)
+		{
+			if (nodes[visit].nodeId != nodeId) continue;
+			forEachRunInVisit(visit, [seqPos, nodeOffset, &found](size_t, const EditRun& run, size_t runSeqPos, size_t runNodeOffset)
+			{
+				if (run.type == Deletion)
+				{
+					if (runSeqPos == seqPos && nodeOffset >= runNodeOffset && nodeOffset < runNodeOffset + run.length) found = true;
+				}
+				else if (seqPos >= runSeqPos && seqPos < runSeqPos + run.length)
+				{
+					if (run.type == Insertion && nodeOffset == runNodeOffset) found = true;
+					if (run.type != Insertion && nodeOffset == runNodeOffset + (seqPos - runSeqPos)) found = true;
+				}
+			});
+		}
+		return found;
+	}
+	std::vector<NodeVisit> nodes;
+	std::vector<EditRun> edits;
+	size_t seqStart;
+	size_t seqEnd;
+	size_t numCells;
+	int32_t score;
+private:
+	template <typename F>
+	void forEachRunInVisit(size_t visit, F&& f) const
+	{
+		size_t seqPos = nodes[visit].seqPos;
+		size_t nodeOffset = nodes[visit].startOffset;
+		for (size_t i = editsStart(visit); i < nodes[visit].editsEnd; i++)
+		{
+			const EditRun& run = edits[i];
+			if (i > editsStart(visit))
+			{
+				if (run.type != Deletion) seqPos += 1;
+				if (run.type != Insertion) nodeOffset += 1;
+			}
+			f(visit, run, seqPos, nodeOffset);
+			//move to the run's last cell
+			if (run.type != Deletion) seqPos += run.length - 1;
+			if (run.type != Insertion) nodeOffset += run.length - 1;
+		}
+	}
+	static bool characterMatch(char sequenceCharacter, char graphCharacter)
+	{
+		return GraphAlignerCommon<size_t, int32_t, uint64_t>::characterMatch(sequenceCharacter, graphCharacter);
+	}
+	void addEdit(EditType type, size_t visitEditsStart)
+	{
+		if (edits.size() > visitEditsStart && edits.back().type == type && edits.back().length < std::numeric_limits<uint32_t>::max())
+		{
+			edits.back().length += 1;
+			return;
+		}
+		edits.push_back(EditRun { 1, type });
+	}
+};
+
 class AlignmentResult
 {
 public:
@@ -338,8 +550,9 @@ public:
 		alignmentXScore(-1),
 		mappingQuality(255)
 		{
-			this->trace = std::make_shared<GraphAlignerCommon<size_t, int32_t, uint64_t>::OnewayTrace>();
-			*this->trace = std::move(trace);
+			//the per cell trace is freed when this returns
+			GraphAlignerCommon<size_t, int32_t, uint64_t>::OnewayTrace fullTrace = std::move(trace);
+			this->trace = std::make_shared<CompactTrace>(fullTrace.trace, fullTrace.score);
 		}
 		bool alignmentFailed() const
 		{
@@ -350,9 +563,8 @@ public:
 			return alignmentEnd - alignmentStart;
 		}
 		std::string corrected;
-		std::string GAFline;
 		std::shared_ptr<vg::Alignment> alignment;
-		std::shared_ptr<GraphAlignerCommon<size_t, int32_t, uint64_t>::OnewayTrace> trace;
+		std::shared_ptr<CompactTrace> trace;
 		size_t seedGoodness;
 		size_t cellsProcessed;
 		size_t elapsedMilliseconds;
@@ -367,4 +579,111 @@ public:
 	std::string readName;
 };
 
+//the DP cells and read positions covered by the alignments of one read so far
+//seeds inside an earlier alignment are skipped with one lookup instead of checking every alignment
+//cells are stored per edit run of the compact traces: matches and mismatches as intervals of sequence positions on a diagonal,
+//insertions as intervals of sequence positions on a node offset and deletions as intervals of node offsets on a sequence position
+class AlignmentCoverage
+{
+public:
+	AlignmentCoverage(size_t sequenceLength) :
+	lines(),
+	bestSeedGoodness()
+	{
+		bestSeedGoodness.resize(sequenceLength + 1, 0);
+	}
+	void add(const AlignmentResult::AlignmentItem& alignment)
+	{
+		assert(alignment.trace != nullptr);
+		const CompactTrace& trace = *alignment.trace;
+		size_t oldSize = lines.size();
+		trace.forEachRun([this, &trace](size_t visit, const CompactTrace::EditRun& run, size_t seqPos, size_t nodeOffset)
+		{
+			int nodeId = trace.nodes[visit].nodeId;
+			switch(run.type)
+			{
+				case CompactTrace::Match:
+				case CompactTrace::Mismatch:
+					lines.push_back(CoveredLine { nodeId, Diagonal, (int64_t)seqPos - (int64_t)nodeOffset, seqPos, seqPos + run.length });
+					break;
+				case CompactTrace::Insertion:
+					lines.push_back(CoveredLine { nodeId, Column, (int64_t)nodeOffset, seqPos, seqPos + run.length });
+					break;
+				case CompactTrace::Deletion:
+					lines.push_back(CoveredLine { nodeId, Row, (int64_t)seqPos, nodeOffset, nodeOffset + run.length });
+					break;
+			}
+		});
+		std::sort(lines.begin() + oldSize, lines.end());
+		std::inplace_merge(lines.begin(), lines.begin() + oldSize, lines.end());
+		//merge overlapping and touching intervals so a lookup only needs to check the last interval starting before the position
+		size_t merged = 0;
+		for (size_t i = 1; i < lines.size(); i++)
+		{
+			if (lines[i].sameLine(lines[merged]) && lines[i].start <= lines[merged].end)
+			{
+				lines[merged].end = std::max(lines[merged].end, lines[i].end);
+				continue;
+			}
+			merged += 1;
+			lines[merged] = lines[i];
+		}
+		if (lines.size() > 0) lines.resize(merged + 1);
+		//goodness + 1 so uncovered positions are 0
+		for (size_t i = alignment.alignmentStart; i <= alignment.alignmentEnd && i < bestSeedGoodness.size(); i++)
+		{
+			bestSeedGoodness[i] = std::max(bestSeedGoodness[i], alignment.seedGoodness + 1);
+		}
+	}
+	bool containsCell(size_t seqPos, int nodeId, size_t nodeOffset) const
+	{
+		if (covers(nodeId, Diagonal, (int64_t)seqPos - (int64_t)nodeOffset, seqPos)) return true;
+		if (covers(nodeId, Column, (int64_t)nodeOffset, seqPos)) return true;
+		return covers(nodeId, Row, (int64_t)seqPos, nodeOffset);
+	}
+	//if any alignment overlaps the read position, or only alignments from seeds better than seedGoodness
+	bool overlaps(size_t seqPos, size_t seedGoodness, bool anyAlignment) const
+	{
+		if (seqPos >= bestSeedGoodness.size()) return false;
+		if (anyAlignment) return bestSeedGoodness[seqPos] > 0;
+		return bestSeedGoodness[seqPos] > seedGoodness + 1;
+	}
+private:
+	enum LineType : uint8_t
+	{
+		Diagonal,
+		Column,
+		Row
+	};
+	//cells [start, end) along one line of a node's DP matrix
+	class CoveredLine
+	{
+	public:
+		int nodeId;
+		LineType type;
+		int64_t line;
+		size_t start;
+		size_t end;
+		bool sameLine(const CoveredLine& other) const
+		{
+			return nodeId == other.nodeId && type == other.type && line == other.line;
+		}
+		bool operator<(const CoveredLine& other) const
+		{
+			return std::tie(nodeId, type, line, start) < std::tie(other.nodeId, other.type, other.line, other.start);
+		}
+	};
+	bool covers(int nodeId, LineType type, int64_t line, size_t pos) const
+	{
+		CoveredLine key { nodeId, type, line, pos, pos };
+		auto iter = std::upper_bound(lines.begin(), lines.end(), key);
+		if (iter == lines.begin()) return false;
+		--iter;
+		return iter->sameLine(key) && iter->end > pos;
+	}
+	//sorted by line and start, no two intervals of the same line overlap
+	std::vector<CoveredLine> lines;
+	std::vector<size_t> bestSeedGoodness;
+};
+
 #endif
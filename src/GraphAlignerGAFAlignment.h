@@ -1,6 +1,7 @@
 #ifndef GraphAlignerGAFAlignment_h
 #define GraphAlignerGAFAlignment_h
 
+#include <cstdio>
 #include <string>
 #include <vector>
 #include "AlignmentGraph.h"
@@ -16,13 +17,6 @@ class GraphAlignerGAFAlignment
 	using Params = typename Common::Params;
 	using MatrixPosition = typename Common::MatrixPosition;
 	using TraceItem = typename Common::TraceItem;
-	struct MergedNodePos
-	{
-		int nodeId;
-		bool reverse;
-		size_t nodeOffset;
-		size_t seqPos;
-	};
 	enum EditType
 	{
 		Match,
@@ -34,214 +28,178 @@ class GraphAlignerGAFAlignment
 	};
 public:
 
-	static std::string traceToAlignment(const std::string& seq_id, const std::string& sequence, const GraphAlignerCommon<size_t, int32_t, uint64_t>::OnewayTrace& tracePair, double alignmentXScore, int mappingQuality, const Params& params, bool cigarMatchMismatchMerge)
+	//appends the GAF line without the trailing newline to out
+	static void traceToAlignment(const std::string& seq_id, const std::string& sequence, const CompactTrace& trace, double alignmentXScore, int mappingQuality, const Params& params, bool cigarMatchMismatchMerge, std::string& out)
 	{
-		auto& trace = tracePair.trace;
-		if (trace.size() == 0) return nullptr;
-		std::stringstream cigar;
-		std::string readName = seq_id;
+		if (trace.nodes.size() == 0) return;
+		std::string cigar;
 		size_t readLen = sequence.size();
-		size_t readStart = trace[0].DPposition.seqPos;
-		size_t readEnd = trace.back().DPposition.seqPos+1;
+		size_t readStart = trace.seqStart;
+		size_t readEnd = trace.seqEnd;
 		bool strand = true;
-		std::stringstream nodePath;
+		//the path comes before any of the fields calculated in the loop so it can be written directly
+		out += seq_id;
+		out += '\t';
+		addNumber(out, readLen);
+		out += '\t';
+		addNumber(out, readStart);
+		out += '\t';
+		addNumber(out, readEnd);
+		out += '\t';
+		out += (strand ? '+' : '-');
+		out += '\t';
 		size_t nodePathLen = 0;
-		size_t nodePathStart = trace[0].DPposition.nodeOffset;
+		size_t nodePathStart = trace.nodes[0].startOffset;
 		size_t nodePathEnd = 0;
-		size_t matches = 0;
-		size_t blockLength = trace.size();
+		size_t blockLength = trace.numCells;
 
-		MergedNodePos currentPos;
-		currentPos.nodeId = trace[0].DPposition.node;
-		currentPos.reverse = (trace[0].DPposition.node % 2) == 1;
-		currentPos.nodeOffset = trace[0].DPposition.nodeOffset;
-		currentPos.seqPos = trace[0].DPposition.seqPos;
-		EditType currentEdit = Empty;
+		for (size_t i = 0; i < trace.nodes.size(); i++)
+		{
+			addPosToString(out, trace.nodes[i].nodeId, params);
+			assert(trace.nodes[i].endOffset < params.graph.originalNodeSize.at(trace.nodes[i].nodeId));
+			nodePathLen += params.graph.originalNodeSize.at(trace.nodes[i].nodeId);
+			if (i > 0)
+			{
+				size_t skippedBefore = params.graph.originalNodeSize.at(trace.nodes[i-1].nodeId) - 1 - trace.nodes[i-1].endOffset;
+				size_t skippedAfter = trace.nodes[i].startOffset;
+				nodePathLen -= skippedBefore + skippedAfter;
+			}
+		}
+
+		size_t matches = 0;
 		size_t mismatches = 0;
 		size_t deletions = 0;
 		size_t insertions = 0;
+		EditType currentEdit = Empty;
 		size_t editLength = 0;
-		if (cigarMatchMismatchMerge)
+		for (const auto& run : trace.edits)
 		{
-			currentEdit = MatchOrMismatch;
-			editLength = 1;
-			if (Common::characterMatch(trace[0].sequenceCharacter, trace[0].graphCharacter))
+			EditType type = Empty;
+			switch(run.type)
 			{
-				matches += 1;
+				case CompactTrace::Match:
+					type = cigarMatchMismatchMerge ? MatchOrMismatch : Match;
+					matches += run.length;
+					break;
+				case CompactTrace::Mismatch:
+					type = cigarMatchMismatchMerge ? MatchOrMismatch : Mismatch;
+					mismatches += run.length;
+					break;
+				case CompactTrace::Insertion:
+					type = Insertion;
+					insertions += run.length;
+					break;
+				case CompactTrace::Deletion:
+					type = Deletion;
+					deletions += run.length;
+					break;
 			}
-			else
+			//runs are split at node visits but the cigar isn't
+			if (type != currentEdit)
 			{
-				mismatches += 1;
+				addCigarItem(cigar, editLength, currentEdit);
+				currentEdit = type;
+				editLength = 0;
 			}
+			editLength += run.length;
 		}
-		else if (Common::characterMatch(trace[0].sequenceCharacter, trace[0].graphCharacter))
-		{
-			currentEdit = Match;
-			editLength = 1;
-			matches += 1;
-		}
-		else
-		{
-			currentEdit = Mismatch;
-			editLength = 1;
-			mismatches += 1;
-		}
-		addPosToString(nodePath, currentPos, params);
-		nodePathLen += params.graph.originalNodeSize.at(currentPos.nodeId);
-		for (size_t pos = 1; pos < trace.size(); pos++)
-		{
-			assert(trace[pos].DPposition.seqPos < sequence.size());
-			MergedNodePos newPos;
-			newPos.nodeId = trace[pos].DPposition.node;
-			newPos.reverse = (trace[pos].DPposition.node % 2) == 1;
-			newPos.nodeOffset = trace[pos].DPposition.nodeOffset;
-			newPos.seqPos = trace[pos].DPposition.seqPos;
-			bool insideNode = !trace[pos-1].nodeSwitch || (newPos.nodeId == currentPos.nodeId && newPos.reverse == currentPos.reverse && newPos.nodeOffset > currentPos.nodeOffset);
 
-			assert(newPos.seqPos >= currentPos.seqPos);
+		assert(matches + mismatches + deletions + insertions == trace.numCells);
+		addCigarItem(cigar, editLength, currentEdit);
 
-			if (!insideNode)
-			{
-				size_t skippedBefore = params.graph.originalNodeSize.at(currentPos.nodeId) - 1 - trace[pos-1].DPposition.nodeOffset;
-				currentPos = newPos;
-				addPosToString(nodePath, currentPos, params);
-				assert(trace[pos].DPposition.nodeOffset < params.graph.originalNodeSize.at(currentPos.nodeId));
-				size_t skippedAfter = trace[pos].DPposition.nodeOffset;
-				nodePathLen += params.graph.originalNodeSize.at(currentPos.nodeId) - (skippedBefore + skippedAfter);
-			}
+		nodePathEnd = nodePathLen - (params.graph.originalNodeSize.at(trace.nodes.back().nodeId) - 1 - trace.nodes.back().endOffset);
 
-			if (trace[pos-1].DPposition.seqPos == trace[pos].DPposition.seqPos)
-			{
-				if (currentEdit == Empty) currentEdit = Deletion;
-				if (currentEdit != Deletion)
-				{
-					addCigarItem(cigar, editLength, currentEdit);
-					currentEdit = Deletion;
-					editLength = 0;
-				}
-				editLength += 1;
-				deletions += 1;
-			}
-			else if (insideNode && trace[pos-1].DPposition.nodeOffset == trace[pos].DPposition.nodeOffset)
-			{
-				if (currentEdit == Empty) currentEdit = Insertion;
-				if (currentEdit != Insertion)
-				{
-					addCigarItem(cigar, editLength, currentEdit);
-					currentEdit = Insertion;
-					editLength = 0;
-				}
-				editLength += 1;
-				insertions += 1;
-			}
-			else if (cigarMatchMismatchMerge)
-			{
-				if (currentEdit == Empty) currentEdit = MatchOrMismatch;
-				if (currentEdit != MatchOrMismatch)
-				{
-					addCigarItem(cigar, editLength, currentEdit);
-					currentEdit = MatchOrMismatch;
-					editLength = 0;
-				}
-				editLength += 1;
-				if (Common::characterMatch(trace[pos].sequenceCharacter, trace[pos].graphCharacter))
-				{
-					matches += 1;
-				}
-				else
-				{
-					mismatches += 1;
-				}
-			}
-			else if (Common::characterMatch(trace[pos].sequenceCharacter, trace[pos].graphCharacter))
-			{
-				if (currentEdit == Empty) currentEdit = Match;
-				if (currentEdit != Match)
-				{
-					addCigarItem(cigar, editLength, currentEdit);
-					currentEdit = Match;
-					editLength = 0;
-				}
-				editLength += 1;
-				matches += 1;
-			}
-			else
-			{
-				if (currentEdit == Empty) currentEdit = Mismatch;
-				if (currentEdit != Mismatch)
-				{
-					addCigarItem(cigar, editLength, currentEdit);
-					currentEdit = Mismatch;
-					editLength = 0;
-				}
-				editLength += 1;
-				mismatches += 1;
-			}
-			if (insideNode)
-			{
-				assert(trace[pos-1].nodeSwitch || newPos.nodeId == currentPos.nodeId);
-				assert(trace[pos-1].nodeSwitch || newPos.reverse == currentPos.reverse);
-			}
+		out += '\t';
+		addNumber(out, nodePathLen);
+		out += '\t';
+		addNumber(out, nodePathStart);
+		out += '\t';
+		addNumber(out, nodePathEnd);
+		out += '\t';
+		addNumber(out, matches);
+		out += '\t';
+		addNumber(out, blockLength);
+		out += '\t';
+		out += std::to_string(mappingQuality);
+		out += "\tNM:i:";
+		addNumber(out, mismatches + deletions + insertions);
+		if (alignmentXScore != -1)
+		{
+			out += "\tAS:f:";
+			addNumber(out, alignmentXScore);
 		}
+		out += "\tdv:f:";
+		addNumber(out, 1.0-((double)matches / (double)(matches + mismatches + deletions + insertions)));
+		out += "\tid:f:";
+		addNumber(out, ((double)matches / (double)(matches + mismatches + deletions + insertions)));
+		out += "\tcg:Z:";
+		out += cigar;
+	}
 
-		assert(matches + mismatches + deletions + insertions == trace.size());
-		addCigarItem(cigar, editLength, currentEdit);
-
-		nodePathEnd = nodePathLen - (params.graph.originalNodeSize.at(trace.back().DPposition.node) - 1 - trace.back().DPposition.nodeOffset);
+private:
 
-		std::stringstream sstr;
-		sstr << readName << "\t" << readLen << "\t" << readStart << "\t" << readEnd << "\t" << (strand ? "+" : "-") << "\t" << nodePath.str() << "\t" << nodePathLen << "\t" << nodePathStart << "\t" << nodePathEnd << "\t" << matches << "\t" << blockLength << "\t" << mappingQuality;
-		sstr << "\t" << "NM:i:" << (mismatches + deletions + insertions);
-		if (alignmentXScore != -1) sstr << "\t" << "AS:f:" << alignmentXScore;
-		sstr << "\t" << "dv:f:" << 1.0-((double)matches / (double)(matches + mismatches + deletions + insertions));
-		sstr << "\t" << "id:f:" << ((double)matches / (double)(matches + mismatches + deletions + insertions));
-		sstr << "\t" << "cg:Z:" << cigar.str();
-		return sstr.str();
+	static void addNumber(std::string& str, size_t number)
+	{
+		char buf[24];
+		size_t pos = sizeof(buf);
+		do
+		{
+			pos -= 1;
+			buf[pos] = '0' + number % 10;
+			number /= 10;
+		} while (number > 0);
+		str.append(buf + pos, sizeof(buf) - pos);
 	}
 
-private:
+	//same formatting as the default ostream formatting of doubles
+	static void addNumber(std::string& str, double number)
+	{
+		char buf[32];
+		int length = snprintf(buf, sizeof(buf), "%g", number);
+		str.append(buf, length);
+	}
 
-	static void addPosToString(std::stringstream& str, MergedNodePos pos, const Params& params)
+	static void addPosToString(std::string& str, int nodeId, const Params& params)
 	{
-		if (pos.reverse)
+		if (nodeId % 2 == 1)
 		{
-			str << "<";
+			str += '<';
 		}
 		else
 		{
-			str << ">";
+			str += '>';
 		}
-		std::string nodeName = params.graph.originalNodeName.at(pos.nodeId);
+		const std::string& nodeName = params.graph.originalNodeName.at(nodeId);
 		if (nodeName == "")
 		{
-			str << pos.nodeId/2;
+			addNumber(str, (size_t)(nodeId/2));
 		}
 		else
 		{
-			str << nodeName;
+			str += nodeName;
 		}
 	}
 
-	static void addCigarItem(std::stringstream& str, size_t editLength, EditType type)
+	static void addCigarItem(std::string& str, size_t editLength, EditType type)
 	{
 		if (editLength == 0) return;
-		str << editLength;
+		addNumber(str, editLength);
 		switch(type)
 		{
 			case MatchOrMismatch:
-				str << "M";
+				str += 'M';
 				break;
 			case Match:
-				str << "=";
+				str += '=';
 				break;
 			case Mismatch:
-				str << "X";
+				str += 'X';
 				break;
 			case Insertion:
-				str << "I";
+				str += 'I';
 				break;
 			case Deletion:
-				str << "D";
+				str += 'D';
 				break;
 			case Empty:
 			default:
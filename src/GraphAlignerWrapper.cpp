@@ -5,34 +5,55 @@
 #include "GraphAligner.h"
 #include "ThreadReadAssertion.h"
 
-AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, size_t initialBandwidth, size_t rampBandwidth, bool quietMode, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t DPRestartStride)
+template <typename LengthType, typename Word>
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, size_t initialBandwidth, size_t rampBandwidth, bool quietMode, typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, size_t DPRestartStride)
 {
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {initialBandwidth, rampBandwidth, graph, std::numeric_limits<size_t>::max(), quietMode, false, lowMemory, forceGlobal, preciseClipping, 1, 0, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, 0};
-	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
+	typename GraphAlignerCommon<LengthType, int32_t, Word>::Params params {initialBandwidth, rampBandwidth, graph, std::numeric_limits<size_t>::max(), quietMode, false, lowMemory, forceGlobal, preciseClipping, 1, 0, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, 0};
+	GraphAligner<LengthType, int32_t, Word> aligner {params};
 	return aligner.AlignOneWay(seq_id, sequence, reusableState, DPRestartStride);
 }
 
-AlignmentResult AlignOneWayDijkstra(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, bool quietMode, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool forceGlobal, bool preciseClipping)
+template <typename LengthType, typename Word>
+AlignmentResult AlignOneWayDijkstra(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, bool quietMode, typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState& reusableState, bool forceGlobal, bool preciseClipping, size_t heuristicKmerLength)
 {
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, graph, std::numeric_limits<size_t>::max(), quietMode, false, true, forceGlobal, preciseClipping, 1, 0, false, .5, 0, 0};
-	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
-	return aligner.AlignOneWayDijkstra(seq_id, sequence, reusableState);
+	typename GraphAlignerCommon<LengthType, int32_t, Word>::Params params {1, 1, graph, std::numeric_limits<size_t>::max(), quietMode, false, true, forceGlobal, preciseClipping, 1, 0, false, .5, 0, 0};
+	GraphAligner<LengthType, int32_t, Word> aligner {params};
+	return aligner.AlignOneWayDijkstra(seq_id, sequence, reusableState, heuristicKmerLength);
 }
 
-AlignmentResult AlignMultiseed(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, double multimapScoreFraction)
+template <typename LengthType, typename Word>
+AlignmentResult AlignMultiseed(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, double multimapScoreFraction)
 {
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {initialBandwidth, rampBandwidth, graph, maxCellsPerSlice, quietMode, sloppyOptimizations, lowMemory, forceGlobal, preciseClipping, minClusterSize, seedExtendDensity, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, multimapScoreFraction};
-	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
+	typename GraphAlignerCommon<LengthType, int32_t, Word>::Params params {initialBandwidth, rampBandwidth, graph, maxCellsPerSlice, quietMode, sloppyOptimizations, lowMemory, forceGlobal, preciseClipping, minClusterSize, seedExtendDensity, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, multimapScoreFraction};
+	GraphAligner<LengthType, int32_t, Word> aligner {params};
 	return aligner.AlignMultiseed(seq_id, sequence, seedHits, reusableState);
 }
 
-AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff)
+template <typename LengthType, typename Word>
+AlignmentResult AlignOneWay(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, size_t initialBandwidth, size_t rampBandwidth, size_t maxCellsPerSlice, bool quietMode, bool sloppyOptimizations, const std::vector<SeedHit>& seedHits, typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState& reusableState, bool lowMemory, bool forceGlobal, bool preciseClipping, size_t minClusterSize, double seedExtendDensity, bool nondeterministicOptimizations, double preciseClippingIdentityCutoff, int Xdropcutoff, AlignerHelperPool<typename GraphAlignerCommon<LengthType, int32_t, Word>::AlignerGraphsizedState>* helperPool)
 {
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {initialBandwidth, rampBandwidth, graph, maxCellsPerSlice, quietMode, sloppyOptimizations, lowMemory, forceGlobal, preciseClipping, minClusterSize, seedExtendDensity, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, 0};
-	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
-	return aligner.AlignOneWay(seq_id, sequence, seedHits, reusableState);
+	typename GraphAlignerCommon<LengthType, int32_t, Word>::Params params {initialBandwidth, rampBandwidth, graph, maxCellsPerSlice, quietMode, sloppyOptimizations, lowMemory, forceGlobal, preciseClipping, minClusterSize, seedExtendDensity, nondeterministicOptimizations, preciseClippingIdentityCutoff, Xdropcutoff, 0};
+	GraphAligner<LengthType, int32_t, Word> aligner {params};
+	return aligner.AlignOneWay(seq_id, sequence, seedHits, reusableState, helperPool);
 }
 
+template AlignmentResult AlignOneWay<size_t, uint64_t>(const AlignmentGraph&, const std::string&, const std::string&, size_t, size_t, bool, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState&, bool, bool, bool, bool, double, int, size_t);
+template AlignmentResult AlignOneWayDijkstra<size_t, uint64_t>(const AlignmentGraph&, const std::string&, const std::string&, bool, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState&, bool, bool, size_t);
+template AlignmentResult AlignMultiseed<size_t, uint64_t>(const AlignmentGraph&, const std::string&, const std::string&, size_t, size_t, size_t, bool, bool, const std::vector<SeedHit>&, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState&, bool, bool, bool, size_t, double, bool, double, int, double);
+template AlignmentResult AlignOneWay<size_t, uint64_t>(const AlignmentGraph&, const std::string&, const std::string&, size_t, size_t, size_t, bool, bool, const std::vector<SeedHit>&, GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState&, bool, bool, bool, size_t, double, bool, double, int, AlignerHelperPool<GraphAlignerCommon<size_t, int32_t, uint64_t>::AlignerGraphsizedState>*);
+template AlignmentResult AlignOneWay<size_t, __uint128_t>(const AlignmentGraph&, const std::string&, const std::string&, size_t, size_t, bool, GraphAlignerCommon<size_t, int32_t, __uint128_t>::AlignerGraphsizedState&, bool, bool, bool, bool, double, int, size_t);
+template AlignmentResult AlignOneWayDijkstra<size_t, __uint128_t>(const AlignmentGraph&, const std::string&, const std::string&, bool, GraphAlignerCommon<size_t, int32_t, __uint128_t>::AlignerGraphsizedState&, bool, bool, size_t);
+template AlignmentResult AlignMultiseed<size_t, __uint128_t>(const AlignmentGraph&, const std::string&, const std::string&, size_t, size_t, size_t, bool, bool, const std::vector<SeedHit>&, GraphAlignerCommon<size_t, int32_t, __uint128_t>::AlignerGraphsizedState&, bool, bool, bool, size_t, double, bool, double, int, double);
+template AlignmentResult AlignOneWay<size_t, __uint128_t>(const AlignmentGraph&, const std::string&, const std::string&, size_t, size_t, size_t, bool, bool, const std::vector<SeedHit>&, GraphAlignerCommon<size_t, int32_t, __uint128_t>::AlignerGraphsizedState&, bool, bool, bool, size_t, double, bool, double, int, AlignerHelperPool<GraphAlignerCommon<size_t, int32_t, __uint128_t>::AlignerGraphsizedState>*);
+template AlignmentResult AlignOneWay<uint32_t, uint64_t>(const AlignmentGraph&, const std::string&, const std::string&, size_t, size_t, bool, GraphAlignerCommon<uint32_t, int32_t, uint64_t>::AlignerGraphsizedState&, bool, bool, bool, bool, double, int, size_t);
+template AlignmentResult AlignOneWayDijkstra<uint32_t, uint64_t>(const AlignmentGraph&, const std::string&, const std::string&, bool, GraphAlignerCommon<uint32_t, int32_t, uint64_t>::AlignerGraphsizedState&, bool, bool, size_t);
+template AlignmentResult AlignMultiseed<uint32_t, uint64_t>(const AlignmentGraph&, const std::string&, const std::string&, size_t, size_t, size_t, bool, bool, const std::vector<SeedHit>&, GraphAlignerCommon<uint32_t, int32_t, uint64_t>::AlignerGraphsizedState&, bool, bool, bool, size_t, double, bool, double, int, double);
+template AlignmentResult AlignOneWay<uint32_t, uint64_t>(const AlignmentGraph&, const std::string&, const std::string&, size_t, size_t, size_t, bool, bool, const std::vector<SeedHit>&, GraphAlignerCommon<uint32_t, int32_t, uint64_t>::AlignerGraphsizedState&, bool, bool, bool, size_t, double, bool, double, int, AlignerHelperPool<GraphAlignerCommon<uint32_t, int32_t, uint64_t>::AlignerGraphsizedState>*);
+template AlignmentResult AlignOneWay<uint32_t, __uint128_t>(const AlignmentGraph&, const std::string&, const std::string&, size_t, size_t, bool, GraphAlignerCommon<uint32_t, int32_t, __uint128_t>::AlignerGraphsizedState&, bool, bool, bool, bool, double, int, size_t);
+template AlignmentResult AlignOneWayDijkstra<uint32_t, __uint128_t>(const AlignmentGraph&, const std::string&, const std::string&, bool, GraphAlignerCommon<uint32_t, int32_t, __uint128_t>::AlignerGraphsizedState&, bool, bool, size_t);
+template AlignmentResult AlignMultiseed<uint32_t, __uint128_t>(const AlignmentGraph&, const std::string&, const std::string&, size_t, size_t, size_t, bool, bool, const std::vector<SeedHit>&, GraphAlignerCommon<uint32_t, int32_t, __uint128_t>::AlignerGraphsizedState&, bool, bool, bool, size_t, double, bool, double, int, double);
+template AlignmentResult AlignOneWay<uint32_t, __uint128_t>(const AlignmentGraph&, const std::string&, const std::string&, size_t, size_t, size_t, bool, bool, const std::vector<SeedHit>&, GraphAlignerCommon<uint32_t, int32_t, __uint128_t>::AlignerGraphsizedState&, bool, bool, bool, size_t, double, bool, double, int, AlignerHelperPool<GraphAlignerCommon<uint32_t, int32_t, __uint128_t>::AlignerGraphsizedState>*);
+
 void AddAlignment(const std::string& seq_id, const std::string& sequence, AlignmentResult::AlignmentItem& alignment)
 {
 	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, AlignmentGraph::DummyGraph(), 1, true, true, true, false, false, 1, 0, false, .5, 0, 0};
@@ -40,16 +61,16 @@ void AddAlignment(const std::string& seq_id, const std::string& sequence, Alignm
 	aligner.AddAlignment(seq_id, sequence, alignment);
 }
 
-void AddGAFLine(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, AlignmentResult::AlignmentItem& alignment, bool cigarMatchMismatchMerge)
+void AddGAFLine(const AlignmentGraph& graph, const std::string& seq_id, const std::string& sequence, const AlignmentResult::AlignmentItem& alignment, bool cigarMatchMismatchMerge, std::string& out)
 {
 	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, graph, 1, true, true, true, false, false, 1, 0, false, .5, 0, 0};
 	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
-	aligner.AddGAFLine(seq_id, sequence, alignment, cigarMatchMismatchMerge);
+	aligner.AddGAFLine(seq_id, sequence, alignment, cigarMatchMismatchMerge, out);
 }
 
-void AddCorrected(AlignmentResult::AlignmentItem& alignment)
+void AddCorrected(const AlignmentGraph& graph, AlignmentResult::AlignmentItem& alignment)
 {
-	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, AlignmentGraph::DummyGraph(), 1, true, true, true, false, false, 1, 0, false, .5, 0, 0};
+	GraphAlignerCommon<size_t, int32_t, uint64_t>::Params params {1, 1, graph, 1, true, true, true, false, false, 1, 0, false, .5, 0, 0};
 	GraphAligner<size_t, int32_t, uint64_t> aligner {params};
 	aligner.AddCorrected(alignment);
 }
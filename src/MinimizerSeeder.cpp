@@ -1,44 +1,40 @@
 #include <queue>
 #include <thread>
+#include <fstream>
 #include <cmath>
-#include <concurrentqueue.h>
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
 #include "CommonUtils.h"
 #include "MinimizerSeeder.h"
+#include "BitvectorSIMD.h"
 
-size_t charToInt(char c)
+//2-bit codes of ACGT, InvalidChar for everything else
+constexpr uint8_t InvalidChar = 4;
+
+std::array<uint8_t, 256> getCharCodes()
 {
-	switch(c)
-	{
-		case 'a':
-		case 'A':
-			return 0;
-		case 'c':
-		case 'C':
-			return 1;
-		case 'g':
-		case 'G':
-			return 2;
-		case 't':
-		case 'T':
-			return 3;
-	}
-	assert(false);
-	return 0;
+	std::array<uint8_t, 256> result;
+	result.fill(InvalidChar);
+	result['a'] = 0;
+	result['A'] = 0;
+	result['c'] = 1;
+	result['C'] = 1;
+	result['g'] = 2;
+	result['G'] = 2;
+	result['t'] = 3;
+	result['T'] = 3;
+	return result;
 }
 
-std::vector<bool> getValidChars()
+const std::array<uint8_t, 256> charCode = getCharCodes();
+
+size_t charToInt(char c)
 {
-	std::vector<bool> result;
-	result.resize(256, false);
-	result['a'] = true;
-	result['A'] = true;
-	result['c'] = true;
-	result['C'] = true;
-	result['g'] = true;
-	result['G'] = true;
-	result['t'] = true;
-	result['T'] = true;
-	return result;
+	assert(charCode[(unsigned char)c] != InvalidChar);
+	return charCode[(unsigned char)c];
 }
 
 // https://naml.us/post/inverse-of-a-hash-function/
@@ -53,50 +49,196 @@ uint64_t hash(uint64_t key) {
 	return key;
 }
 
-std::vector<bool> validChar = getValidChars();
+#ifndef NOAVX2
+//same as hash(), four keys at a time
+__attribute__((target("avx2")))
+void hashKmersAVX2(const uint64_t* keys, uint64_t* result, size_t count)
+{
+	const __m256i ones = _mm256_set1_epi64x(-1);
+	for (size_t i = 0; i + 4 <= count; i += 4)
+	{
+		__m256i key = _mm256_loadu_si256((const __m256i*)(keys + i));
+		key = _mm256_add_epi64(_mm256_xor_si256(key, ones), _mm256_slli_epi64(key, 21));
+		key = _mm256_xor_si256(key, _mm256_srli_epi64(key, 24));
+		key = _mm256_add_epi64(_mm256_add_epi64(key, _mm256_slli_epi64(key, 3)), _mm256_slli_epi64(key, 8));
+		key = _mm256_xor_si256(key, _mm256_srli_epi64(key, 14));
+		key = _mm256_add_epi64(_mm256_add_epi64(key, _mm256_slli_epi64(key, 2)), _mm256_slli_epi64(key, 4));
+		key = _mm256_xor_si256(key, _mm256_srli_epi64(key, 28));
+		key = _mm256_add_epi64(key, _mm256_slli_epi64(key, 31));
+		_mm256_storeu_si256((__m256i*)(result + i), key);
+	}
+}
+#endif
+
+void hashKmers(const uint64_t* keys, uint64_t* result, size_t count)
+{
+	size_t done = 0;
+#ifndef NOAVX2
+	if (BitvectorSIMD::hasAVX2)
+	{
+		hashKmersAVX2(keys, result, count);
+		done = count - count % 4;
+	}
+#endif
+	for (size_t i = done; i < count; i++)
+	{
+		result[i] = hash(keys[i]);
+	}
+}
+
+//the k-mers ending at consecutive positions of a string
+//validLength is the number of valid characters ending at the position, the k-mer is only meaningful if it is at least k
+struct KmerBlock
+{
+	static constexpr size_t Capacity = 256;
+	size_t firstPos;
+	size_t size;
+	uint64_t kmer[Capacity];
+	uint64_t hash[Capacity];
+	size_t validLength[Capacity];
+};
+
+//encodes the string a block at a time. the rolling encoding is serial so hashing is done separately for the whole block
+class KmerBlockReader
+{
+public:
+	KmerBlockReader(const std::string& str, size_t kmerLength) :
+	str(str),
+	mask(~(0xFFFFFFFFFFFFFFFF << (kmerLength * 2))),
+	pos(0),
+	kmer(0),
+	validLength(0)
+	{
+		assert(kmerLength * 2 <= sizeof(size_t) * 8);
+		assert(mask == pow(4, kmerLength)-1);
+	}
+	bool next(KmerBlock& block, bool withHashes)
+	{
+		if (pos == str.size()) return false;
+		block.firstPos = pos;
+		block.size = std::min(KmerBlock::Capacity, str.size() - pos);
+		for (size_t i = 0; i < block.size; i++)
+		{
+			uint8_t code = charCode[(unsigned char)str[pos + i]];
+			if (code == InvalidChar)
+			{
+				validLength = 0;
+				kmer = 0;
+			}
+			else
+			{
+				validLength += 1;
+				kmer = ((kmer << 2) | code) & mask;
+			}
+			block.kmer[i] = kmer;
+			block.validLength[i] = validLength;
+		}
+		pos += block.size;
+		if (withHashes) hashKmers(block.kmer, block.hash, block.size);
+		return true;
+	}
+private:
+	const std::string& str;
+	const size_t mask;
+	size_t pos;
+	size_t kmer;
+	size_t validLength;
+};
 
+//monotone queue of the window's minimizer candidates in a fixed size ring buffer
+class MinimizerWindow
+{
+public:
+	struct Item
+	{
+		size_t pos;
+		size_t kmer;
+		size_t hash;
+	};
+	MinimizerWindow(size_t maxSize) :
+	items(),
+	first(0),
+	count(0),
+	mask(0)
+	{
+		size_t capacity = 1;
+		while (capacity < maxSize) capacity *= 2;
+		items.resize(capacity);
+		mask = capacity - 1;
+	}
+	void clear()
+	{
+		first = 0;
+		count = 0;
+	}
+	bool empty() const
+	{
+		return count == 0;
+	}
+	size_t size() const
+	{
+		return count;
+	}
+	const Item& operator[](size_t index) const
+	{
+		assert(index < count);
+		return items[(first + index) & mask];
+	}
+	const Item& front() const
+	{
+		return (*this)[0];
+	}
+	const Item& back() const
+	{
+		return (*this)[count-1];
+	}
+	void pop_front()
+	{
+		assert(count > 0);
+		first = (first + 1) & mask;
+		count -= 1;
+	}
+	void pop_back()
+	{
+		assert(count > 0);
+		count -= 1;
+	}
+	void push_back(size_t pos, size_t kmer, size_t hash)
+	{
+		assert(count <= mask);
+		items[(first + count) & mask] = Item { pos, kmer, hash };
+		count += 1;
+	}
+private:
+	std::vector<Item> items;
+	size_t first;
+	size_t count;
+	size_t mask;
+};
 
 template <typename CallbackF>
 void iterateKmers(const std::string& str, size_t kmerLength, size_t windowSize, CallbackF callback)
 {
 	const size_t realWindow = windowSize - kmerLength + 1;
-	assert(kmerLength * 2 <= sizeof(size_t) * 8);
 	if (str.size() < kmerLength) return;
-	const size_t mask = ~(0xFFFFFFFFFFFFFFFF << (kmerLength * 2));
-	assert(mask == pow(4, kmerLength)-1);
-	size_t offset = 0;
-start:
-	while (offset < str.size() && !validChar[str[offset]]) offset++;
-	if (offset + kmerLength > str.size()) return;
-	size_t kmer = 0;
-	for (size_t i = 0; i < kmerLength; i++)
-	{
-		if (!validChar[str[offset+i]])
-		{
-			offset += i;
-			goto start;
-		}
-		kmer <<= 2;
-		kmer |= charToInt(str[offset+i]);
-	}
-	callback(offset + kmerLength-1, kmer);
-	size_t lastKmer = kmer;
-	size_t lastPos = offset + kmerLength-1;
-	for (size_t i = kmerLength; offset+i < str.size(); i++)
+	KmerBlockReader reader { str, kmerLength };
+	KmerBlock block;
+	size_t lastKmer = 0;
+	size_t lastPos = 0;
+	while (reader.next(block, false))
 	{
-		if (!validChar[str[offset+i]])
+		for (size_t i = 0; i < block.size; i++)
 		{
-			offset += i;
-			goto start;
-		}
-		kmer <<= 2;
-		kmer &= mask;
-		kmer |= charToInt(str[offset + i]);
-		if (lastKmer != kmer || lastPos <= offset + i - realWindow)
-		{
-			callback(offset + i, kmer);
-			lastKmer = kmer;
-			lastPos = offset + i;
+			if (block.validLength[i] < kmerLength) continue;
+			size_t pos = block.firstPos + i;
+			size_t kmer = block.kmer[i];
+			//repeats of the same k-mer are only reported once per window
+			if (block.validLength[i] == kmerLength || lastKmer != kmer || lastPos <= pos - realWindow)
+			{
+				callback(pos, kmer);
+				lastKmer = kmer;
+				lastPos = pos;
+			}
 		}
 	}
 }
@@ -108,82 +250,100 @@ void iterateMinimizersReal(const std::string& str, size_t minimizerLength, size_
 	assert(minimizerLength <= windowSize);
 	if (str.size() < minimizerLength) return;
 	const size_t realWindow = windowSize - minimizerLength + 1;
-	const size_t mask = ~(0xFFFFFFFFFFFFFFFF << (minimizerLength * 2));
-	assert(mask == pow(4, minimizerLength)-1);
-	size_t offset = 0;
-	std::deque<std::tuple<size_t, size_t, size_t>> window;
-start:
-	while (offset < str.size() && !validChar[str[offset]]) offset++;
-	if (offset + windowSize > str.size()) return;
-	size_t kmer = 0;
-	for (size_t i = 0; i < minimizerLength; i++)
-	{
-		if (!validChar[str[offset+i]])
-		{
-			offset += i;
-			goto start;
-		}
-		kmer <<= 2;
-		kmer |= charToInt(str[offset+i]);
-	}
-	window.clear();
-	window.emplace_back(offset+minimizerLength-1, kmer, hash(kmer));
-	for (size_t i = minimizerLength; i < minimizerLength + realWindow; i++)
+	MinimizerWindow window { realWindow + 1 };
+	KmerBlockReader reader { str, minimizerLength };
+	KmerBlock block;
+	while (reader.next(block, true))
 	{
-		if (!validChar[str[offset + i]])
+		for (size_t i = 0; i < block.size; i++)
 		{
-			offset += i;
-			goto start;
+			size_t validLength = block.validLength[i];
+			if (validLength < minimizerLength) continue;
+			size_t pos = block.firstPos + i;
+			size_t kmer = block.kmer[i];
+			size_t hashed = block.hash[i];
+			if (validLength == minimizerLength)
+			{
+				window.clear();
+				window.push_back(pos, kmer, hashed);
+				continue;
+			}
+			//the first window of a run of valid characters is reported once it is full
+			if (validLength <= windowSize + 1)
+			{
+				while (!window.empty() && window.back().hash > hashed) window.pop_back();
+				window.push_back(pos, kmer, hashed);
+				if (validLength == windowSize + 1)
+				{
+					for (size_t j = 0; j < window.size() && window[j].hash == window.front().hash; j++)
+					{
+						callback(window[j].pos, window[j].kmer);
+					}
+				}
+				continue;
+			}
+			size_t oldMinimum = window.front().hash;
+			bool frontPopped = false;
+			while (!window.empty() && window.front().pos <= pos - realWindow)
+			{
+				frontPopped = true;
+				window.pop_front();
+			}
+			if (frontPopped)
+			{
+				while (window.size() >= 2 && window[0].hash == window[1].hash) window.pop_front();
+			}
+			while (!window.empty() && window.back().hash > hashed) window.pop_back();
+			window.push_back(pos, kmer, hashed);
+			if (window.front().hash != oldMinimum)
+			{
+				for (size_t j = 0; j < window.size() && window[j].hash == window.front().hash; j++)
+				{
+					callback(window[j].pos, window[j].kmer);
+				}
+			}
+			else if (window.back().hash == window.front().hash)
+			{
+				callback(window.back().pos, window.back().kmer);
+			}
 		}
-		kmer <<= 2;
-		kmer &= mask;
-		kmer |= charToInt(str[offset + i]);
-		auto hashed = hash(kmer);
-		while (!window.empty() && std::get<2>(window.back()) > hashed) window.pop_back();
-		window.emplace_back(offset+i, kmer, hashed);
 	}
-	auto iter = window.begin();
-	while (iter != window.end() && std::get<2>(*iter) == std::get<2>(window.front()))
-	{
-		callback(std::get<0>(*iter), std::get<1>(*iter));
-		++iter;
-	}
-	for (size_t i = minimizerLength + realWindow; offset+i < str.size(); i++)
+}
+
+//open syncmers: k-mers whose smallest s-mer is the one in the middle
+//unlike minimizers the choice only depends on the k-mer itself, so the same k-mers are picked in the read and in the graph
+template <typename CallbackF>
+void iterateSyncmers(const std::string& str, size_t kmerLength, size_t smerLength, CallbackF callback)
+{
+	assert(smerLength > 0);
+	assert(smerLength < kmerLength);
+	if (str.size() < kmerLength) return;
+	const size_t smerMask = ~(0xFFFFFFFFFFFFFFFF << (smerLength * 2));
+	const size_t smersInKmer = kmerLength - smerLength + 1;
+	const size_t middle = (kmerLength - smerLength) / 2;
+	MinimizerWindow window { smersInKmer };
+	KmerBlockReader reader { str, kmerLength };
+	KmerBlock block;
+	uint64_t smer[KmerBlock::Capacity];
+	while (reader.next(block, false))
 	{
-		if (!validChar[str[offset+i]])
-		{
-			offset += i;
-			goto start;
-		}
-		kmer <<= 2;
-		kmer &= mask;
-		kmer |= charToInt(str[offset + i]);
-		auto hashed = hash(kmer);
-		size_t oldMinimum = std::get<2>(window.front());
-		bool frontPopped = false;
-		while (!window.empty() && std::get<0>(window.front()) <= offset + i - realWindow)
-		{
-			frontPopped = true;
-			window.pop_front();
-		}
-		if (frontPopped)
+		for (size_t i = 0; i < block.size; i++)
 		{
-			while (window.size() >= 2 && std::get<2>(window.front()) == std::get<2>(*(window.begin()+1))) window.pop_front();
+			smer[i] = block.kmer[i] & smerMask;
 		}
-		while (!window.empty() && std::get<2>(window.back()) > hashed) window.pop_back();
-		window.emplace_back(offset+i, kmer, hashed);
-		if (std::get<2>(window.front()) != oldMinimum)
+		hashKmers(smer, block.hash, block.size);
+		for (size_t i = 0; i < block.size; i++)
 		{
-			auto iter = window.begin();
-			while (iter != window.end() && std::get<2>(*iter) == std::get<2>(window.front()))
-			{
-				callback(std::get<0>(*iter), std::get<1>(*iter));
-				++iter;
-			}
-		}
-		else if (std::get<2>(window.back()) == std::get<2>(window.front()))
-		{
-			callback(std::get<0>(window.back()), std::get<1>(window.back()));
+			size_t validLength = block.validLength[i];
+			if (validLength < smerLength) continue;
+			size_t pos = block.firstPos + i;
+			if (validLength == smerLength) window.clear();
+			while (!window.empty() && window.front().pos + smersInKmer <= pos) window.pop_front();
+			//ties keep the leftmost s-mer at the front
+			while (!window.empty() && window.back().hash > block.hash[i]) window.pop_back();
+			window.push_back(pos, smer[i], block.hash[i]);
+			if (validLength < kmerLength) continue;
+			if (window.front().pos == pos - (kmerLength - smerLength) + middle) callback(pos, block.kmer[i]);
 		}
 	}
 }
@@ -283,43 +443,149 @@ void iterateMinimizers(const std::string& str, size_t minimizerLength, size_t wi
 
 #endif
 
-MinimizerSeeder::MinimizerSeeder(const AlignmentGraph& graph, size_t minimizerLength, size_t windowSize, size_t numThreads, double keepLeastFrequentFraction) :
+MinimizerSeeder::MinimizerSeeder(const AlignmentGraph& graph, size_t minimizerLength, size_t windowSize, size_t syncmerLength, size_t numThreads, double keepLeastFrequentFraction, const std::string& cachePrefix, size_t buildMemoryBudget) :
 graph(graph),
 buckets(),
 minimizerLength(minimizerLength),
 windowSize(windowSize),
+syncmerLength(syncmerLength),
 maxCount(0)
 {
 	assert(minimizerLength * 2 <= sizeof(size_t) * 8);
 	assert(minimizerLength <= windowSize);
-	initMinimizers(numThreads);
+	assert(syncmerLength < minimizerLength);
+	if (cachePrefix.size() == 0 || !loadFrom(cacheFileName(cachePrefix)))
+	{
+		initMinimizers(numThreads, buildMemoryBudget);
+		if (cachePrefix.size() > 0) saveTo(cacheFileName(cachePrefix));
+	}
 	initMaxCount(keepLeastFrequentFraction);
 }
 
-void MinimizerSeeder::initMinimizers(size_t numThreads)
+std::string MinimizerSeeder::cacheFileName(const std::string& cachePrefix) const
+{
+	if (syncmerLength > 0) return cachePrefix + "_k" + std::to_string(minimizerLength) + "_s" + std::to_string(syncmerLength) + ".minimizers";
+	return cachePrefix + "_k" + std::to_string(minimizerLength) + "_w" + std::to_string(windowSize) + ".minimizers";
+}
+
+//cache file: magic, version, graph checksum, k, w, syncmer s, bucket count, then each bucket's mphf and vectors
+constexpr uint64_t MinimizerCacheMagic = 0x5A494E494D414147; //"GAAMINIZ"
+constexpr uint64_t MinimizerCacheVersion = 2;
+
+uint64_t MinimizerSeeder::graphChecksum() const
+{
+	uint64_t result = graph.NodeSize();
+	auto mix = [&result](uint64_t value)
+	{
+		result = hash(result ^ (value + 0x9E3779B97F4A7C15 + (result << 6) + (result >> 2)));
+	};
+	for (size_t i = 0; i < graph.NodeSize(); i++)
+	{
+		mix(graph.nodeIDs[i]);
+		mix(graph.nodeOffset[i]);
+		mix(graph.nodeLength[i]);
+	}
+	for (size_t i = 0; i < graph.nodeSequences.size(); i++)
+	{
+		for (size_t j = 0; j < AlignmentGraph::CHUNKS_IN_NODE; j++)
+		{
+			mix(graph.nodeSequences[i][j]);
+		}
+	}
+	for (size_t i = 0; i < graph.ambiguousNodeSequences.size(); i++)
+	{
+		mix(graph.ambiguousNodeSequences[i].A);
+		mix(graph.ambiguousNodeSequences[i].C);
+		mix(graph.ambiguousNodeSequences[i].G);
+		mix(graph.ambiguousNodeSequences[i].T);
+	}
+	return result;
+}
+
+//writes to a temporary file which is renamed over filename when complete, so a concurrent run never loads a partial index
+void MinimizerSeeder::saveTo(const std::string& filename) const
+{
+	std::string tmpFile = filename + ".tmp" + std::to_string(getpid());
+	std::ofstream file { tmpFile, std::ios::binary };
+	if (!file.good())
+	{
+		std::cerr << "Could not write minimizer index to " << filename << std::endl;
+		return;
+	}
+	uint64_t header[7] { MinimizerCacheMagic, MinimizerCacheVersion, graphChecksum(), minimizerLength, windowSize, syncmerLength, buckets.size() };
+	file.write((const char*)header, sizeof(header));
+	for (size_t i = 0; i < buckets.size(); i++)
+	{
+		assert(buckets[i].locator != nullptr);
+		buckets[i].locator->save(file);
+		buckets[i].kmerCheck.serialize(file);
+		buckets[i].startPos.serialize(file);
+		buckets[i].positions.serialize(file);
+	}
+	file.close();
+	if (file.fail() || std::rename(tmpFile.c_str(), filename.c_str()) != 0)
+	{
+		std::cerr << "Could not write minimizer index to " << filename << std::endl;
+		std::remove(tmpFile.c_str());
+	}
+}
+
+bool MinimizerSeeder::loadFrom(const std::string& filename)
+{
+	std::ifstream file { filename, std::ios::binary };
+	if (!file.good()) return false;
+	uint64_t header[7];
+	file.read((char*)header, sizeof(header));
+	if (!file.good()) return false;
+	if (header[0] != MinimizerCacheMagic || header[1] != MinimizerCacheVersion) return false;
+	if (header[3] != minimizerLength || header[4] != windowSize || header[5] != syncmerLength || header[6] == 0) return false;
+	if (header[2] != graphChecksum())
+	{
+		std::cout << "Minimizer index " << filename << " was built from a different graph, rebuilding" << std::endl;
+		return false;
+	}
+	std::cout << "Load minimizer index from " << filename << std::endl;
+	std::vector<KmerBucket> loaded;
+	loaded.resize(header[6]);
+	for (size_t i = 0; i < loaded.size(); i++)
+	{
+		loaded[i].locator = new KmerBucket::boophf_t;
+		loaded[i].locator->load(file);
+		loaded[i].kmerCheck.load(file);
+		loaded[i].startPos.load(file);
+		loaded[i].positions.load(file);
+		if (!file.good() || loaded[i].startPos.size() != loaded[i].locator->nbKeys() + 1 || loaded[i].kmerCheck.size() != loaded[i].locator->nbKeys())
+		{
+			std::cout << "Minimizer index " << filename << " is corrupted, rebuilding" << std::endl;
+			return false;
+		}
+	}
+	buckets = std::move(loaded);
+	return true;
+}
+
+template <typename F>
+void runThreads(size_t numThreads, F f)
 {
-	size_t positionSize = log2(graph.nodeIDs.size()) + 1;
-	assert(positionSize + 6 < 64);
-	assert(minimizerLength * 2 < 64);
-	auto nodeIter = graph.nodeLookup.begin();
-	std::mutex nodeMutex;
 	std::vector<std::thread> threads;
-	std::vector<sdsl::int_vector<0>> kmerPerBucket;
-	std::vector<sdsl::int_vector<0>> positionPerBucket;
-	std::vector<moodycamel::ConcurrentQueue<std::pair<uint64_t, uint64_t>>> positionDistributor;
-	kmerPerBucket.resize(numThreads);
-	positionPerBucket.resize(numThreads);
-	positionDistributor.resize(numThreads);
-	buckets.resize(numThreads);
-	std::atomic<size_t> threadsDone;
-	threadsDone = 0;
-	for (size_t i = 0; i < numThreads; i++)
-	{
-		kmerPerBucket[i].width(minimizerLength * 2);
-		positionPerBucket[i].width(positionSize + 6);
-		buckets[i].positions.width(positionSize + 6);
+	for (size_t thread = 0; thread < numThreads; thread++)
+	{
+		threads.emplace_back([&f, thread]() { f(thread); });
+	}
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
 	}
+}
 
+//the index is built in passes over the graph's nodes, with the nodes split into chunks which the threads pick up in any order
+//the first pass counts the minimizers per chunk and bucket, so later passes can write each chunk's minimizers straight to their final place in one array
+//if the array doesn't fit in the memory budget, the buckets are split into rounds which each repeat the minimizer extraction
+void MinimizerSeeder::initMinimizers(size_t numThreads, size_t memoryBudget)
+{
+	size_t positionSize = log2(graph.nodeIDs.size()) + 1;
+	assert(positionSize + 6 < 64);
+	assert(minimizerLength * 2 < 64);
 	std::unordered_map<size_t, size_t> nodeMinimizerStart;
 	for (size_t i = 0; i < graph.NodeSize(); i++)
 	{
@@ -339,156 +605,215 @@ void MinimizerSeeder::initMinimizers(size_t numThreads)
 		}
 	}
 
-	for (size_t thread = 0; thread < numThreads; thread++)
+	std::vector<int> nodes;
+	size_t totalLength = 0;
+	for (const auto& pair : graph.nodeLookup)
 	{
-		threads.emplace_back([this, &nodeMinimizerStart, &positionDistributor, &threadsDone, &kmerPerBucket, &positionPerBucket, thread, numThreads, &nodeMutex, &nodeIter, positionSize](){
-			size_t vecPos = 0;
-			kmerPerBucket[thread].resize(10);
-			positionPerBucket[thread].resize(10);
-			std::pair<uint64_t, uint64_t> readThis;
-			while (true)
+		nodes.push_back(pair.first);
+		totalLength += graph.originalNodeSize.at(pair.first);
+	}
+	const size_t maxChunks = numThreads * 8;
+	std::vector<size_t> chunkStart;
+	chunkStart.push_back(0);
+	size_t lengthHere = 0;
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		lengthHere += graph.originalNodeSize.at(nodes[i]);
+		if (lengthHere * maxChunks >= totalLength && i+1 < nodes.size())
+		{
+			chunkStart.push_back(i+1);
+			lengthHere = 0;
+		}
+	}
+	chunkStart.push_back(nodes.size());
+	const size_t numChunks = chunkStart.size()-1;
+	auto iterateChunkMinimizers = [this, &nodes, &chunkStart, &nodeMinimizerStart, positionSize](size_t chunk, auto callback)
+	{
+		std::string sequence;
+		for (size_t i = chunkStart[chunk]; i < chunkStart[chunk+1]; i++)
+		{
+			int nodeId = nodes[i];
+			sequence.resize(graph.originalNodeSize.at(nodeId));
+			for (size_t pos = 0; pos < sequence.size(); pos++)
 			{
-				auto iter = graph.nodeLookup.end();
-				{
-					std::lock_guard<std::mutex> guard { nodeMutex };
-					iter = nodeIter;
-					if (nodeIter != graph.nodeLookup.end()) ++nodeIter;
-				}
-				if (iter == graph.nodeLookup.end()) break;
-				int nodeId = iter->first;
-				int firstNode = iter->second[0];
-				std::string sequence;
-				sequence.resize(graph.originalNodeSize.at(nodeId));
-				for (size_t pos = 0; pos < sequence.size(); pos++)
-				{
-					size_t nodeidHere = graph.GetUnitigNode(nodeId, pos);
-					sequence[pos] = graph.NodeSequences(nodeidHere, pos - graph.nodeOffset[nodeidHere]);
-				}
-				iterateMinimizers(sequence, minimizerLength, windowSize, [this, &nodeMinimizerStart, &positionDistributor, &kmerPerBucket, &positionPerBucket, &vecPos, positionSize, thread, nodeId](size_t pos, size_t kmer)
-				{
-					if (pos < nodeMinimizerStart.at(nodeId)) return;
-					size_t splitNode = graph.GetUnitigNode(nodeId, pos);
-					assert(splitNode < (size_t)1 << positionSize);
-					size_t remainingOffset = pos - graph.nodeOffset[splitNode];
-					assert(remainingOffset < 64);
-					std::pair<uint64_t, uint64_t> readThis;
-					while (positionDistributor[thread].try_dequeue(readThis))
-					{
-						assert(readThis.first < ((uint64_t)1) << (kmerPerBucket[thread].width()));
-						assert(readThis.second < ((uint64_t)1) << (positionPerBucket[thread].width()));
-						assert(getBucket(readThis.first) == thread);
-						if (vecPos == kmerPerBucket[thread].size())
-						{
-							kmerPerBucket[thread].resize(kmerPerBucket[thread].size() * 2);
-							positionPerBucket[thread].resize(kmerPerBucket[thread].size() * 2);
-						}
-						kmerPerBucket[thread][vecPos] = readThis.first;
-						positionPerBucket[thread][vecPos] = readThis.second;
-						vecPos += 1;
-					}
-					std::pair<uint64_t, uint64_t> storeThis;
-					storeThis.first = kmer;
-					size_t bucket = getBucket(kmer);
-					storeThis.second = splitNode;
-					storeThis.second <<= 6;
-					storeThis.second += remainingOffset;
-					positionDistributor[bucket].enqueue(storeThis);
-				});
+				size_t nodeidHere = graph.GetUnitigNode(nodeId, pos);
+				sequence[pos] = graph.NodeSequences(nodeidHere, pos - graph.nodeOffset[nodeidHere]);
 			}
-			threadsDone += 1;
-			while (threadsDone < numThreads)
+			size_t minimizerStart = nodeMinimizerStart.at(nodeId);
+			auto addPosition = [this, &callback, minimizerStart, positionSize, nodeId](size_t pos, size_t kmer)
 			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(10));
-				while (positionDistributor[thread].try_dequeue(readThis))
-				{
-					assert(readThis.first < ((uint64_t)1) << (kmerPerBucket[thread].width()));
-					assert(readThis.second < ((uint64_t)1) << (positionPerBucket[thread].width()));
-					assert(getBucket(readThis.first) == thread);
-					if (vecPos == kmerPerBucket[thread].size())
-					{
-						kmerPerBucket[thread].resize(kmerPerBucket[thread].size() * 2);
-						positionPerBucket[thread].resize(kmerPerBucket[thread].size() * 2);
-					}
-					kmerPerBucket[thread][vecPos] = readThis.first;
-					positionPerBucket[thread][vecPos] = readThis.second;
-					vecPos += 1;
-				}
+				if (pos < minimizerStart) return;
+				size_t splitNode = graph.GetUnitigNode(nodeId, pos);
+				assert(splitNode < (size_t)1 << positionSize);
+				size_t remainingOffset = pos - graph.nodeOffset[splitNode];
+				assert(remainingOffset < 64);
+				callback(kmer, (splitNode << 6) + remainingOffset);
+			};
+			if (syncmerLength > 0)
+			{
+				iterateSyncmers(sequence, minimizerLength, syncmerLength, addPosition);
 			}
-			while (positionDistributor[thread].try_dequeue(readThis))
+			else
 			{
-				assert(readThis.first < ((uint64_t)1) << (kmerPerBucket[thread].width()));
-				assert(readThis.second < ((uint64_t)1) << (positionPerBucket[thread].width()));
-				assert(getBucket(readThis.first) == thread);
-				if (vecPos == kmerPerBucket[thread].size())
-				{
-					kmerPerBucket[thread].resize(kmerPerBucket[thread].size() * 2);
-					positionPerBucket[thread].resize(kmerPerBucket[thread].size() * 2);
-				}
-				kmerPerBucket[thread][vecPos] = readThis.first;
-				positionPerBucket[thread][vecPos] = readThis.second;
-				vecPos += 1;
+				iterateMinimizers(sequence, minimizerLength, windowSize, addPosition);
 			}
-			kmerPerBucket[thread].resize(vecPos);
-			positionPerBucket[thread].resize(vecPos);
+		}
+	};
+
+	//counted by kmer % numPartitions. the bucket count divides it so the bucket counts can be summed from these
+	const size_t numPartitions = numThreads * 8;
+	std::vector<size_t> partitionCount;
+	partitionCount.resize(numChunks * numPartitions, 0);
+	std::atomic<size_t> nextChunk { 0 };
+	runThreads(numThreads, [&iterateChunkMinimizers, &partitionCount, &nextChunk, numChunks, numPartitions](size_t thread)
+	{
+		while (true)
+		{
+			size_t chunk = nextChunk++;
+			if (chunk >= numChunks) break;
+			size_t* counts = partitionCount.data() + chunk * numPartitions;
+			iterateChunkMinimizers(chunk, [counts, numPartitions](size_t kmer, size_t position) { counts[kmer % numPartitions] += 1; });
+		}
+	});
+
+	//more buckets than threads only when a bucket would be over the budget
+	const size_t bytesPerMinimizer = sizeof(std::pair<uint64_t, uint64_t>);
+	size_t numBuckets = numThreads;
+	std::vector<size_t> bucketChunkCount;
+	while (true)
+	{
+		bucketChunkCount.assign(numBuckets * numChunks, 0);
+		std::vector<size_t> bucketCount;
+		bucketCount.resize(numBuckets, 0);
+		for (size_t chunk = 0; chunk < numChunks; chunk++)
+		{
+			for (size_t partition = 0; partition < numPartitions; partition++)
 			{
-				std::vector<uint64_t> locatorKeys;
-				{
-					sdsl::int_vector<0> sortedKmers;
-					sortedKmers = kmerPerBucket[thread];
-					std::sort(sortedKmers.begin(), sortedKmers.end(), [positionSize](uint64_t left, uint64_t right) { return left < right; });
-					size_t current = std::numeric_limits<size_t>::max();
-					for (uint64_t kmer : sortedKmers)
-					{
-						assert(getBucket(kmer) == thread);
-						if (kmer == current)
-						{
-							continue;
-						}
-						current = kmer;
-						locatorKeys.push_back(current);
-					}
-				}
-				buckets[thread].locator = new boomphf::mphf<uint64_t,KmerBucket::hasher_t>(locatorKeys.size(), locatorKeys, 1, 2, true, false);
+				bucketChunkCount[(partition % numBuckets) * numChunks + chunk] += partitionCount[chunk * numPartitions + partition];
+				bucketCount[partition % numBuckets] += partitionCount[chunk * numPartitions + partition];
 			}
-			buckets[thread].startPos.width(log2(kmerPerBucket[thread].size())+1);
-			buckets[thread].startPos.resize(buckets[thread].locator->nbKeys() + 1);
-			buckets[thread].kmerCheck.width(minimizerLength * 2);
-			buckets[thread].kmerCheck.resize(buckets[thread].locator->nbKeys());
-			sdsl::util::set_to_value(buckets[thread].startPos, 0);
-			for (size_t i = 0; i < kmerPerBucket[thread].size(); i++)
+		}
+		size_t largestBucket = *std::max_element(bucketCount.begin(), bucketCount.end());
+		if (memoryBudget == 0 || largestBucket * bytesPerMinimizer <= memoryBudget || numBuckets == numPartitions) break;
+		numBuckets *= 2;
+	}
+	partitionCount.clear();
+	partitionCount.shrink_to_fit();
+	buckets.clear();
+	buckets.resize(numBuckets);
+
+	std::vector<std::pair<uint64_t, uint64_t>> minimizers;
+	size_t roundStart = 0;
+	while (roundStart < numBuckets)
+	{
+		//offset of each chunk's part of each bucket in this round
+		std::vector<size_t> writeOffset;
+		std::vector<size_t> bucketStart;
+		size_t roundEnd = roundStart;
+		size_t roundSize = 0;
+		while (roundEnd < numBuckets)
+		{
+			size_t bucketSize = 0;
+			for (size_t chunk = 0; chunk < numChunks; chunk++) bucketSize += bucketChunkCount[roundEnd * numChunks + chunk];
+			if (roundEnd > roundStart && memoryBudget != 0 && (roundSize + bucketSize) * bytesPerMinimizer > memoryBudget) break;
+			bucketStart.push_back(roundSize);
+			for (size_t chunk = 0; chunk < numChunks; chunk++)
 			{
-				uint64_t kmer = kmerPerBucket[thread][i];
-				size_t index = buckets[thread].locator->lookup(kmer);
-				buckets[thread].startPos[index] += 1;
-				buckets[thread].kmerCheck[index] = kmer;
+				writeOffset.push_back(roundSize);
+				roundSize += bucketChunkCount[roundEnd * numChunks + chunk];
 			}
-			if (buckets[thread].startPos.size() > 0)
+			roundEnd += 1;
+		}
+		bucketStart.push_back(roundSize);
+		minimizers.resize(roundSize);
+		nextChunk = 0;
+		runThreads(numThreads, [&iterateChunkMinimizers, &writeOffset, &minimizers, &nextChunk, numChunks, numBuckets, roundStart, roundEnd](size_t thread)
+		{
+			std::vector<size_t> offset;
+			while (true)
 			{
-				for (size_t i = 1; i < buckets[thread].startPos.size(); i++)
-				{
-					buckets[thread].startPos[i] += buckets[thread].startPos[i-1];
-				}
-				assert(buckets[thread].startPos[buckets[thread].startPos.size()-1] == kmerPerBucket[thread].size());
-				buckets[thread].positions.resize(kmerPerBucket[thread].size());
-				for (size_t i = 0; i < kmerPerBucket[thread].size(); i++)
+				size_t chunk = nextChunk++;
+				if (chunk >= numChunks) break;
+				offset.clear();
+				for (size_t bucket = roundStart; bucket < roundEnd; bucket++) offset.push_back(writeOffset[(bucket - roundStart) * numChunks + chunk]);
+				iterateChunkMinimizers(chunk, [&minimizers, &offset, numBuckets, roundStart, roundEnd](size_t kmer, size_t position)
 				{
-					size_t kmer = kmerPerBucket[thread][i];
-					size_t index = buckets[thread].locator->lookup(kmer);
-					assert(buckets[thread].startPos[index] > 0);
-					buckets[thread].startPos[index] -= 1;
-					size_t pos = buckets[thread].startPos[index];
-					uint64_t insert = positionPerBucket[thread][i];
-					buckets[thread].positions[pos] = insert;
-				};
+					size_t bucket = kmer % numBuckets;
+					if (bucket < roundStart || bucket >= roundEnd) return;
+					minimizers[offset[bucket - roundStart]] = std::make_pair(kmer, position);
+					offset[bucket - roundStart] += 1;
+				});
 			}
 		});
+		std::atomic<size_t> nextBucket { roundStart };
+		runThreads(numThreads, [this, &minimizers, &bucketStart, &nextBucket, roundStart, roundEnd, positionSize](size_t thread)
+		{
+			while (true)
+			{
+				size_t bucket = nextBucket++;
+				if (bucket >= roundEnd) break;
+				auto begin = minimizers.begin() + bucketStart[bucket - roundStart];
+				auto end = minimizers.begin() + bucketStart[bucket - roundStart + 1];
+				buildBucket(buckets[bucket], begin, end, positionSize);
+			}
+		});
+		roundStart = roundEnd;
 	}
+}
 
-	for (size_t i = 0; i < threads.size(); i++)
+//sorted by k-mer, all occurrences of one k-mer are next to each other so each k-mer is looked up only once
+void MinimizerSeeder::buildBucket(KmerBucket& bucket, std::vector<std::pair<uint64_t, uint64_t>>::iterator begin, std::vector<std::pair<uint64_t, uint64_t>>::iterator end, size_t positionSize)
+{
+	std::sort(begin, end);
+	std::vector<uint64_t> locatorKeys;
+	for (auto iter = begin; iter != end; ++iter)
 	{
-		threads[i].join();
+		assert(getBucket(iter->first) == (size_t)(&bucket - buckets.data()));
+		if (locatorKeys.size() == 0 || iter->first != locatorKeys.back()) locatorKeys.push_back(iter->first);
+	}
+	bucket.locator = new KmerBucket::boophf_t(locatorKeys.size(), locatorKeys, 1, 2, true, false);
+	size_t numMinimizers = end - begin;
+	bucket.startPos.width(log2(numMinimizers + 1) + 1);
+	bucket.startPos.resize(bucket.locator->nbKeys() + 1);
+	bucket.kmerCheck.width(minimizerLength * 2);
+	bucket.kmerCheck.resize(bucket.locator->nbKeys());
+	bucket.positions.width(positionSize + 6);
+	bucket.positions.resize(numMinimizers);
+	std::vector<uint64_t> keyIndex;
+	keyIndex.reserve(locatorKeys.size());
+	std::vector<size_t> count;
+	count.resize(bucket.locator->nbKeys(), 0);
+	size_t keyStart = 0;
+	for (size_t i = 0; i < numMinimizers; i++)
+	{
+		if (i+1 < numMinimizers && begin[i+1].first == begin[i].first) continue;
+		size_t index = bucket.locator->lookup(begin[i].first);
+		assert(index < count.size());
+		keyIndex.push_back(index);
+		count[index] = i + 1 - keyStart;
+		bucket.kmerCheck[index] = begin[i].first;
+		keyStart = i + 1;
+	}
+	size_t sum = 0;
+	for (size_t i = 0; i < count.size(); i++)
+	{
+		bucket.startPos[i] = sum;
+		sum += count[i];
+	}
+	bucket.startPos[count.size()] = sum;
+	assert(sum == numMinimizers);
+	keyStart = 0;
+	for (size_t key = 0; key < keyIndex.size(); key++)
+	{
+		size_t pos = bucket.startPos[keyIndex[key]];
+		for (size_t i = 0; i < count[keyIndex[key]]; i++)
+		{
+			assert(begin[keyStart + i].second < ((uint64_t)1) << (positionSize + 6));
+			bucket.positions[pos + i] = begin[keyStart + i].second;
+		}
+		keyStart += count[keyIndex[key]];
 	}
-	threads.clear();
+	assert(keyStart == numMinimizers);
 }
 
 void MinimizerSeeder::addMinimizers(std::vector<SeedHit>& result, std::vector<std::tuple<size_t, size_t, size_t, size_t>>& matchIndices, size_t maxCount) const
@@ -519,23 +844,66 @@ void MinimizerSeeder::addMinimizers(std::vector<SeedHit>& result, std::vector<st
 	}
 }
 
+template <typename IntVector>
+void prefetchEntry(const IntVector& vec, size_t index)
+{
+	__builtin_prefetch(vec.data() + index * vec.width() / 64);
+}
+
 std::vector<SeedHit> MinimizerSeeder::getSeeds(const std::string& sequence, double density) const
 {
 	std::vector<std::tuple<size_t, size_t, size_t, size_t>> matchIndices;
-	iterateKmers(sequence, minimizerLength, windowSize, [this, &matchIndices](size_t pos, size_t kmer)
-	{
-		size_t bucket = getBucket(kmer);
-		assert(bucket < buckets.size());
-		size_t index = buckets[bucket].locator->lookup(kmer);
-		if (index == ULLONG_MAX) return;
-		assert(index < buckets[bucket].kmerCheck.size());
-		if (buckets[bucket].kmerCheck[(size_t)index] != kmer) return;
-		size_t start = getStart(bucket, index);
-		size_t end = getStart(bucket, index+1);
-		size_t count = end - start;
-		if (count >= maxCount) return;
-		matchIndices.emplace_back(pos, bucket, start, count);
-	});
+	//look up a batch of k-mers and prefetch their entries before checking any of them, so the cache misses overlap
+	constexpr size_t BatchSize = 16;
+	size_t batchPos[BatchSize];
+	size_t batchKmer[BatchSize];
+	size_t batchBucket[BatchSize];
+	uint64_t batchIndex[BatchSize];
+	size_t batchSize = 0;
+	auto lookupBatch = [this, &matchIndices, &batchPos, &batchKmer, &batchBucket, &batchIndex, &batchSize]()
+	{
+		for (size_t i = 0; i < batchSize; i++)
+		{
+			size_t bucket = getBucket(batchKmer[i]);
+			assert(bucket < buckets.size());
+			batchBucket[i] = bucket;
+			batchIndex[i] = buckets[bucket].locator->lookup(batchKmer[i]);
+			if (batchIndex[i] == ULLONG_MAX) continue;
+			prefetchEntry(buckets[bucket].kmerCheck, batchIndex[i]);
+			prefetchEntry(buckets[bucket].startPos, batchIndex[i]);
+		}
+		for (size_t i = 0; i < batchSize; i++)
+		{
+			size_t bucket = batchBucket[i];
+			uint64_t index = batchIndex[i];
+			if (index == ULLONG_MAX) continue;
+			assert(index < buckets[bucket].kmerCheck.size());
+			if (buckets[bucket].kmerCheck[(size_t)index] != batchKmer[i]) continue;
+			size_t start = getStart(bucket, index);
+			size_t end = getStart(bucket, index+1);
+			size_t count = end - start;
+			if (count >= maxCount) continue;
+			matchIndices.emplace_back(batchPos[i], bucket, start, count);
+		}
+		batchSize = 0;
+	};
+	auto addKmer = [&batchPos, &batchKmer, &batchSize, &lookupBatch](size_t pos, size_t kmer)
+	{
+		batchPos[batchSize] = pos;
+		batchKmer[batchSize] = kmer;
+		batchSize += 1;
+		if (batchSize == BatchSize) lookupBatch();
+	};
+	//the graph only has the syncmers indexed and they are picked the same way in the read, so other k-mers can't match
+	if (syncmerLength > 0)
+	{
+		iterateSyncmers(sequence, minimizerLength, syncmerLength, addKmer);
+	}
+	else
+	{
+		iterateKmers(sequence, minimizerLength, windowSize, addKmer);
+	}
+	lookupBatch();
 	std::vector<SeedHit> result;
 	size_t maxHits = sequence.size() * density;
 	if (density == -1) maxHits = std::numeric_limits<size_t>::max();
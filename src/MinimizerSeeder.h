@@ -29,7 +29,7 @@ class MinimizerSeeder
 		sdsl::int_vector<0> positions;
 	};
 public:
-	MinimizerSeeder(const AlignmentGraph& graph, size_t minimizerLength, size_t windowSize, size_t numThreads, double keepLeastFrequentFraction);
+	MinimizerSeeder(const AlignmentGraph& graph, size_t minimizerLength, size_t windowSize, size_t syncmerLength, size_t numThreads, double keepLeastFrequentFraction, const std::string& cachePrefix, size_t buildMemoryBudget);
 	std::vector<SeedHit> getSeeds(const std::string& sequence, double density) const;
 	bool canSeed() const;
 private:
@@ -37,12 +37,18 @@ private:
 	size_t getStart(size_t bucket, size_t index) const;
 	size_t getBucket(size_t hash) const;
 	SeedHit matchToSeedHit(int nodeId, size_t nodeOffset, size_t seqPos, int count) const;
-	void initMinimizers(size_t numThreads);
+	void initMinimizers(size_t numThreads, size_t memoryBudget);
+	void buildBucket(KmerBucket& bucket, std::vector<std::pair<uint64_t, uint64_t>>::iterator begin, std::vector<std::pair<uint64_t, uint64_t>>::iterator end, size_t positionSize);
 	void initMaxCount(double keepLeastFrequentFraction);
+	std::string cacheFileName(const std::string& cachePrefix) const;
+	uint64_t graphChecksum() const;
+	void saveTo(const std::string& filename) const;
+	bool loadFrom(const std::string& filename);
 	const AlignmentGraph& graph;
 	std::vector<KmerBucket> buckets;
 	size_t minimizerLength;
 	size_t windowSize;
+	size_t syncmerLength;
 	size_t maxCount;
 };
 
@@ -0,0 +1,136 @@
+#ifndef NodeBitvector_h
+#define NodeBitvector_h
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <phmap.h>
+#include "ThreadReadAssertion.h"
+
+//one bit per node, either dense or as a hash set of the set bits
+//sparse mode uses memory proportional to the set bits instead of the graph size
+//clear() is proportional to the number of bits set since the last clear, not the graph size
+class NodeBitvector
+{
+public:
+	class Reference
+	{
+	public:
+		Reference(NodeBitvector& vec, size_t index) :
+		vec(vec),
+		index(index)
+		{
+		}
+		operator bool() const
+		{
+			return vec.get(index);
+		}
+		Reference& operator=(bool value)
+		{
+			vec.set(index, value);
+			return *this;
+		}
+	private:
+		NodeBitvector& vec;
+		size_t index;
+	};
+	NodeBitvector() :
+	words(),
+	setBits(),
+	touched(),
+	touchedOverflow(false),
+	numBits(0),
+	sparse(false)
+	{
+	}
+	void resize(size_t size, bool sparseStorage)
+	{
+		assert(numBits == 0);
+		numBits = size;
+		sparse = sparseStorage;
+		if (!sparse) words.resize((size + 63) / 64, 0);
+	}
+#ifdef NDEBUG
+	__attribute__((always_inline))
+#endif
+	bool get(size_t index) const
+	{
+		assert(index < numBits);
+		if (sparse) return setBits.count(index) == 1;
+		return (words[index / 64] >> (index % 64)) & 1;
+	}
+#ifdef NDEBUG
+	__attribute__((always_inline))
+#endif
+	void set(size_t index, bool value)
+	{
+		assert(index < numBits);
+		if (sparse)
+		{
+			if (value) setBits.insert(index); else setBits.erase(index);
+			return;
+		}
+		uint64_t mask = (uint64_t)1 << (index % 64);
+		if (value)
+		{
+			if (words[index / 64] == 0 && !touchedOverflow)
+			{
+				//past this point clearing all words is cheaper than remembering the touched ones
+				if (touched.size() >= words.size())
+				{
+					touchedOverflow = true;
+					touched.clear();
+					touched.shrink_to_fit();
+				}
+				else
+				{
+					touched.push_back(index / 64);
+				}
+			}
+			words[index / 64] |= mask;
+		}
+		else
+		{
+			words[index / 64] &= ~mask;
+		}
+	}
+	bool operator[](size_t index) const
+	{
+		return get(index);
+	}
+	Reference operator[](size_t index)
+	{
+		return Reference { *this, index };
+	}
+	size_t size() const
+	{
+		return numBits;
+	}
+	void clear()
+	{
+		if (sparse)
+		{
+			setBits.clear();
+			return;
+		}
+		if (touchedOverflow)
+		{
+			if (words.size() > 0) memset(words.data(), 0, words.size() * sizeof(uint64_t));
+		}
+		else
+		{
+			for (auto word : touched) words[word] = 0;
+		}
+		touched.clear();
+		touchedOverflow = false;
+	}
+private:
+	std::vector<uint64_t> words;
+	phmap::flat_hash_set<size_t> setBits;
+	std::vector<size_t> touched;
+	bool touchedOverflow;
+	size_t numBits;
+	bool sparse;
+};
+
+#endif
@@ -8,6 +8,7 @@
 #include <type_traits>
 #include <phmap.h>
 #include "AlignmentGraph.h"
+#include "DPArena.h"
 #include "ThreadReadAssertion.h"
 #include "WordSlice.h"
 
@@ -51,7 +52,7 @@ class NodeSlice
 {
 public:
 	using NodeSliceMapItem = NodeSliceMapItemStruct<LengthType, ScoreType, Word>;
-	using MapType = phmap::flat_hash_map<size_t, NodeSliceMapItem>;
+	using MapType = ArenaHashMap<size_t, NodeSliceMapItem>;
 	using MapItem = NodeSliceMapItem;
 	class NodeSliceIterator : std::iterator<std::forward_iterator_tag, std::pair<size_t, MapItem>>
 	{
@@ -201,7 +202,7 @@ public:
 	void addEmptyNodeMap(size_t size)
 	{
 		assert(nodes == nullptr);
-		nodes = std::make_shared<MapType>();
+		nodes = std::allocate_shared<MapType>(ArenaAllocator<MapType>{});
 		nodes->reserve(size);
 	}
 	template <bool HasVectorMap = UseVectorMap>
@@ -304,7 +305,7 @@ public:
 	typename std::enable_if<HasVectorMap>::type removeNonExistant()
 	{
 		assert(vectorMap != nullptr);
-		std::vector<size_t> newActiveVectorMapIndices;
+		ArenaVector<size_t> newActiveVectorMapIndices;
 		newActiveVectorMapIndices.reserve(activeVectorMapIndices.size());
 		for (auto index : activeVectorMapIndices)
 		{
@@ -316,13 +317,13 @@ public:
 	typename std::enable_if<!HasVectorMap>::type removeNonExistant()
 	{
 		assert(nodes != nullptr);
-		std::vector<std::pair<size_t, MapItem>> newActiveMapItems;
+		ArenaVector<std::pair<size_t, MapItem>> newActiveMapItems;
 		newActiveMapItems.reserve(activeVectorMapIndices.size());
 		for (auto item : (*nodes))
 		{
 			if (item.second.exists) newActiveMapItems.push_back(item);
 		}
-		nodes = std::make_shared<MapType>();
+		nodes = std::allocate_shared<MapType>(ArenaAllocator<MapType>{});
 		nodes->resize(newActiveMapItems.size());
 		for (auto item : newActiveMapItems)
 		{
@@ -418,7 +419,7 @@ private:
 		activeVectorMapIndices.clear();
 	}
 	std::vector<NodeSliceMapItem>* vectorMap;
-	std::vector<size_t> activeVectorMapIndices;
+	ArenaVector<size_t> activeVectorMapIndices;
 	std::shared_ptr<MapType> nodes;
 	friend class NodeSliceIterator;
 	friend class NodeSliceConstIterator;
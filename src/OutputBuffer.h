@@ -0,0 +1,114 @@
+#ifndef OutputBuffer_h
+#define OutputBuffer_h
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <blockingconcurrentqueue.h>
+
+//aligner threads append their output to large buffers which are handed to the writer thread once full
+//the writer returns written buffers to the free list. there is a fixed number of buffers
+//so aligner threads wait for a slow writer instead of queuing up output without bound
+class OutputQueue
+{
+public:
+	OutputQueue(size_t numBuffers, size_t bufferSize) :
+	freeBuffers(numBuffers),
+	fullBuffers(numBuffers),
+	buffers(),
+	bufferSize(bufferSize)
+	{
+		for (size_t i = 0; i < numBuffers; i++)
+		{
+			buffers.emplace_back(std::make_unique<std::string>());
+			freeBuffers.enqueue(buffers.back().get());
+		}
+	}
+	OutputQueue(const OutputQueue& other) = delete;
+	OutputQueue& operator=(const OutputQueue& other) = delete;
+	//returns the number of buffers written to result, waits up to timeout if there are none
+	template <typename Duration>
+	size_t getFull(std::string** result, size_t max, Duration timeout)
+	{
+		return fullBuffers.wait_dequeue_bulk_timed(result, max, timeout);
+	}
+	void recycle(std::string* buffer)
+	{
+		buffer->clear();
+		//don't keep the memory of an unusually large read around
+		if (buffer->capacity() > bufferSize * 4) buffer->shrink_to_fit();
+		freeBuffers.enqueue(buffer);
+	}
+	size_t fullBufferCount() const
+	{
+		return fullBuffers.size_approx();
+	}
+private:
+	std::string* getEmpty()
+	{
+		std::string* result;
+		freeBuffers.wait_dequeue(result);
+		if (result->capacity() < bufferSize * 2) result->reserve(bufferSize * 2);
+		return result;
+	}
+	moodycamel::BlockingConcurrentQueue<std::string*> freeBuffers;
+	moodycamel::BlockingConcurrentQueue<std::string*> fullBuffers;
+	std::vector<std::unique_ptr<std::string>> buffers;
+	const size_t bufferSize;
+	friend class ThreadOutputBuffer;
+};
+
+//one aligner thread's current buffer for one output
+class ThreadOutputBuffer
+{
+public:
+	ThreadOutputBuffer(OutputQueue& queue) :
+	queue(queue),
+	token(queue.fullBuffers),
+	current(nullptr)
+	{
+	}
+	ThreadOutputBuffer(const ThreadOutputBuffer& other) = delete;
+	ThreadOutputBuffer& operator=(const ThreadOutputBuffer& other) = delete;
+	~ThreadOutputBuffer()
+	{
+		flush();
+	}
+	//the output of one read. if f throws, whatever it appended is removed so the file doesn't get a partial record
+	template <typename F>
+	void append(F f)
+	{
+		if (current == nullptr) current = queue.getEmpty();
+		size_t oldSize = current->size();
+		try
+		{
+			f(*current);
+		}
+		catch (...)
+		{
+			current->resize(oldSize);
+			throw;
+		}
+		if (current->size() >= queue.bufferSize) flush();
+	}
+	void flush()
+	{
+		if (current == nullptr) return;
+		if (current->size() == 0)
+		{
+			queue.recycle(current);
+		}
+		else
+		{
+			queue.fullBuffers.enqueue(token, current);
+		}
+		current = nullptr;
+	}
+private:
+	OutputQueue& queue;
+	moodycamel::ProducerToken token;
+	std::string* current;
+};
+
+#endif
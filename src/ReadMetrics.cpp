@@ -0,0 +1,190 @@
+#include <cstdio>
+#include <limits>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include "ReadMetrics.h"
+
+namespace ReadMetrics
+{
+	std::string metricName(Metric metric)
+	{
+		switch(metric)
+		{
+			case SeedingTime:
+				return "seeding_us";
+			case ClusteringTime:
+				return "clustering_us";
+			case AlignmentTime:
+				return "alignment_us";
+			case BacktraceTime:
+				return "backtrace_us";
+			case SelectionTime:
+				return "selection_us";
+			case SerializationTime:
+				return "serialization_us";
+			case QueueWaitTime:
+				return "queue_wait_us";
+			case DPCells:
+				return "dp_cells";
+			case Slices:
+				return "slices";
+			case BandRamps:
+				return "band_ramps";
+			case DPAllocations:
+				return "dp_allocations";
+			case DPMallocs:
+				return "dp_mallocs";
+			case NumMetrics:
+				break;
+		}
+		return "unknown";
+	}
+
+	size_t bucketIndex(uint64_t value)
+	{
+		if (value == 0) return 0;
+		return 64 - __builtin_clzll(value);
+	}
+
+	uint64_t bucketUpperBound(size_t bucket)
+	{
+		if (bucket == 0) return 0;
+		if (bucket == 64) return std::numeric_limits<uint64_t>::max();
+		return ((uint64_t)1 << bucket) - 1;
+	}
+
+	Histogram::Histogram() :
+	count(0),
+	sum(0),
+	max(0)
+	{
+		for (size_t i = 0; i < NumBuckets; i++) buckets[i] = 0;
+	}
+
+	void Histogram::record(uint64_t value)
+	{
+		//only the owning thread writes so relaxed updates are enough, readers may see a slightly old state
+		buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+		count.fetch_add(1, std::memory_order_relaxed);
+		sum.fetch_add(value, std::memory_order_relaxed);
+		if (value > max.load(std::memory_order_relaxed)) max.store(value, std::memory_order_relaxed);
+	}
+
+	void Histogram::addTo(uint64_t* bucketsOut, uint64_t& countOut, uint64_t& sumOut, uint64_t& maxOut) const
+	{
+		for (size_t i = 0; i < NumBuckets; i++) bucketsOut[i] += buckets[i].load(std::memory_order_relaxed);
+		countOut += count.load(std::memory_order_relaxed);
+		sumOut += sum.load(std::memory_order_relaxed);
+		maxOut = std::max(maxOut, max.load(std::memory_order_relaxed));
+	}
+
+	ThreadMetrics& Registry::addThread()
+	{
+		std::lock_guard<std::mutex> guard { mutex };
+		threads.emplace_back();
+		return threads.back();
+	}
+
+	class Summary
+	{
+	public:
+		Summary() :
+		buckets(),
+		count(0),
+		sum(0),
+		max(0)
+		{
+		}
+		uint64_t percentile(double fraction) const
+		{
+			if (count == 0) return 0;
+			uint64_t rank = fraction * count;
+			uint64_t seen = 0;
+			for (size_t i = 0; i < Histogram::NumBuckets; i++)
+			{
+				seen += buckets[i];
+				if (seen > rank) return std::min(bucketUpperBound(i), max);
+			}
+			return max;
+		}
+		double mean() const
+		{
+			if (count == 0) return 0;
+			return (double)sum / (double)count;
+		}
+		uint64_t buckets[Histogram::NumBuckets];
+		uint64_t count;
+		uint64_t sum;
+		uint64_t max;
+	};
+
+	Summary summarize(const std::deque<ThreadMetrics>& threads, Metric metric)
+	{
+		Summary result;
+		for (const auto& thread : threads)
+		{
+			thread.histograms[metric].addTo(result.buckets, result.count, result.sum, result.max);
+		}
+		return result;
+	}
+
+	std::string Registry::toJSON() const
+	{
+		std::lock_guard<std::mutex> guard { mutex };
+		std::stringstream str;
+		str << "{\"threads\":" << threads.size() << ",\"metrics\":{";
+		for (size_t metric = 0; metric < NumMetrics; metric++)
+		{
+			Summary summary = summarize(threads, (Metric)metric);
+			if (metric > 0) str << ",";
+			str << "\"" << metricName((Metric)metric) << "\":{";
+			str << "\"count\":" << summary.count << ",\"sum\":" << summary.sum << ",\"mean\":" << summary.mean() << ",\"max\":" << summary.max;
+			str << ",\"p50\":" << summary.percentile(0.5) << ",\"p90\":" << summary.percentile(0.9) << ",\"p99\":" << summary.percentile(0.99);
+			str << ",\"histogram\":[";
+			bool first = true;
+			for (size_t i = 0; i < Histogram::NumBuckets; i++)
+			{
+				if (summary.buckets[i] == 0) continue;
+				if (!first) str << ",";
+				first = false;
+				str << "{\"le\":" << bucketUpperBound(i) << ",\"count\":" << summary.buckets[i] << "}";
+			}
+			str << "]}";
+		}
+		str << "}}" << std::endl;
+		return str.str();
+	}
+
+	std::string Registry::toTSV() const
+	{
+		std::lock_guard<std::mutex> guard { mutex };
+		std::stringstream str;
+		str << "metric\tcount\tsum\tmean\tmax\tp50\tp90\tp99" << std::endl;
+		for (size_t metric = 0; metric < NumMetrics; metric++)
+		{
+			Summary summary = summarize(threads, (Metric)metric);
+			str << metricName((Metric)metric) << "\t" << summary.count << "\t" << summary.sum << "\t" << summary.mean() << "\t" << summary.max << "\t" << summary.percentile(0.5) << "\t" << summary.percentile(0.9) << "\t" << summary.percentile(0.99) << std::endl;
+		}
+		return str.str();
+	}
+
+	void Registry::writeFile(const std::string& filename) const
+	{
+		bool json = filename.size() >= 5 && filename.substr(filename.size()-5) == ".json";
+		std::string contents = json ? toJSON() : toTSV();
+		//write to a temporary file first so a periodic report is never seen half written
+		std::string tmpFile = filename + ".tmp";
+		{
+			std::ofstream file { tmpFile };
+			if (!file.good())
+			{
+				std::cerr << "Could not write metrics to " << filename << std::endl;
+				return;
+			}
+			file << contents;
+		}
+		std::rename(tmpFile.c_str(), filename.c_str());
+	}
+}
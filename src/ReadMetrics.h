@@ -0,0 +1,113 @@
+#ifndef ReadMetrics_h
+#define ReadMetrics_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+
+//per read measurements of each alignment stage
+//every thread records into its own histograms so recording doesn't need locks, the report sums them up
+namespace ReadMetrics
+{
+	enum Metric
+	{
+		SeedingTime,
+		ClusteringTime,
+		AlignmentTime,
+		BacktraceTime,
+		SelectionTime,
+		SerializationTime,
+		QueueWaitTime,
+		DPCells,
+		Slices,
+		BandRamps,
+		DPAllocations,
+		DPMallocs,
+		NumMetrics
+	};
+
+	std::string metricName(Metric metric);
+
+	//log2 buckets, bucket i has values in [2^(i-1), 2^i)
+	class Histogram
+	{
+	public:
+		static constexpr size_t NumBuckets = 65;
+		Histogram();
+		void record(uint64_t value);
+		void addTo(uint64_t* bucketsOut, uint64_t& countOut, uint64_t& sumOut, uint64_t& maxOut) const;
+	private:
+		std::atomic<uint64_t> buckets[NumBuckets];
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> sum;
+		std::atomic<uint64_t> max;
+	};
+
+	class ThreadMetrics
+	{
+	public:
+		void record(Metric metric, uint64_t value)
+		{
+			histograms[metric].record(value);
+		}
+		Histogram histograms[NumMetrics];
+	};
+
+	class Registry
+	{
+	public:
+		//the returned object lives as long as the registry
+		ThreadMetrics& addThread();
+		std::string toJSON() const;
+		std::string toTSV() const;
+		//.json or .tsv by extension
+		void writeFile(const std::string& filename) const;
+	private:
+		mutable std::mutex mutex;
+		std::deque<ThreadMetrics> threads;
+	};
+
+	//counters for the stages inside the aligner, kept in the alignment state and reset for each read
+	class AlignerCounters
+	{
+	public:
+		AlignerCounters() :
+		slices(0),
+		bandRamps(0),
+		backtraceMicroseconds(0)
+		{
+		}
+		void clear()
+		{
+			slices = 0;
+			bandRamps = 0;
+			backtraceMicroseconds = 0;
+		}
+		size_t slices;
+		size_t bandRamps;
+		size_t backtraceMicroseconds;
+	};
+
+	//adds the time between construction and destruction to target
+	class ScopedTimer
+	{
+	public:
+		ScopedTimer(size_t& target) :
+		target(target),
+		start(std::chrono::steady_clock::now())
+		{
+		}
+		~ScopedTimer()
+		{
+			target += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+	private:
+		size_t& target;
+		std::chrono::steady_clock::time_point start;
+	};
+}
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef SeedHeuristic_h
+#define SeedHeuristic_h
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <phmap.h>
+#include "AlignmentGraph.h"
+#include "ThreadReadAssertion.h"
+
+//lower bound for the edit cost of aligning the rest of a read anywhere in the graph, for guiding the optimal aligner like A*
+//the read is cut into disjoint k-mers. a k-mer which doesn't occur in the graph has at least one edit inside it in any alignment,
+//so the number of such k-mers after a read position bounds the cost of aligning the read from there on
+class SeedHeuristic
+{
+public:
+	static constexpr size_t MaxKmerLength = 32;
+	//result[i] is the number of absent k-mers which start at or after read position i, for i in [0, sequence.size()]
+	static std::vector<size_t> getAbsentKmersAfter(const AlignmentGraph& graph, const std::string_view& sequence, size_t k)
+	{
+		assert(k > 0);
+		assert(k <= MaxKmerLength);
+		SeedHeuristic heuristic { graph, k };
+		std::vector<uint64_t> readKmers;
+		std::vector<bool> usable;
+		for (size_t start = 0; start + k <= sequence.size(); start += k)
+		{
+			uint64_t kmer = 0;
+			bool exact = true;
+			for (size_t i = 0; i < k; i++)
+			{
+				uint8_t mask = baseMask(sequence[start+i]);
+				//ambiguous read characters can match several graph k-mers, don't use those
+				if (mask != 1 && mask != 2 && mask != 4 && mask != 8) exact = false;
+				kmer = (kmer << 2) + maskBase(mask);
+			}
+			readKmers.push_back(kmer);
+			usable.push_back(exact);
+			if (exact) heuristic.absent.insert(kmer);
+		}
+		heuristic.removeGraphKmers();
+		std::vector<size_t> result;
+		result.resize(sequence.size()+1, 0);
+		for (size_t i = sequence.size(); i > 0; i--)
+		{
+			size_t pos = i-1;
+			result[pos] = result[pos+1];
+			if (pos % k != 0 || pos / k >= readKmers.size()) continue;
+			if (usable[pos / k] && heuristic.absent.count(readKmers[pos / k]) == 1) result[pos] += 1;
+		}
+		return result;
+	}
+private:
+	//branches of the graph or of ambiguous characters followed from one start position before the rest are given up on
+	static constexpr size_t MaxBranches = 64;
+	SeedHeuristic(const AlignmentGraph& graph, size_t k) :
+	graph(graph),
+	k(k),
+	absent()
+	{
+	}
+	//bit per base in ACGT order, the same bases as GraphAlignerCommon::ambiguousMatch
+	static uint8_t baseMask(char c)
+	{
+		switch(c)
+		{
+			case 'A': case 'a': return 1;
+			case 'C': case 'c': return 2;
+			case 'G': case 'g': return 4;
+			case 'T': case 't': case 'U': case 'u': return 8;
+			case 'R': case 'r': return 1 | 4;
+			case 'Y': case 'y': return 2 | 8;
+			case 'K': case 'k': return 4 | 8;
+			case 'M': case 'm': return 1 | 2;
+			case 'S': case 's': return 2 | 4;
+			case 'W': case 'w': return 1 | 8;
+			case 'B': case 'b': return 2 | 4 | 8;
+			case 'D': case 'd': return 1 | 4 | 8;
+			case 'H': case 'h': return 1 | 2 | 8;
+			case 'V': case 'v': return 1 | 2 | 4;
+			case 'N': case 'n': return 1 | 2 | 4 | 8;
+		}
+		return 0;
+	}
+	static uint64_t maskBase(uint8_t mask)
+	{
+		switch(mask)
+		{
+			case 2: return 1;
+			case 4: return 2;
+			case 8: return 3;
+		}
+		return 0;
+	}
+	//removes every read k-mer which matches some path in the graph, or might match one where the search was given up
+	void removeGraphKmers()
+	{
+		for (size_t node = 0; node < graph.NodeSize() && absent.size() > 0; node++)
+		{
+			size_t length = graph.NodeLength(node);
+			size_t firstCrossing = 0;
+			if (node < graph.firstAmbiguous && length >= k)
+			{
+				uint64_t kmer = 0;
+				for (size_t i = 0; i < length; i++)
+				{
+					kmer = ((kmer << 2) + maskBase(baseMask(graph.NodeSequences(node, i)))) & kmerMask();
+					if (i+1 >= k) absent.erase(kmer);
+				}
+				firstCrossing = length - k + 1;
+			}
+			for (size_t start = firstCrossing; start < length; start++)
+			{
+				size_t branches = MaxBranches;
+				removeFrom(node, start, 0, 0, branches);
+			}
+		}
+	}
+	void removeFrom(size_t node, size_t offset, uint64_t kmer, size_t kmerLength, size_t& branches)
+	{
+		while (kmerLength < k)
+		{
+			if (offset == graph.NodeLength(node))
+			{
+				auto neighbors = graph.outNeighbors[node];
+				if (neighbors.size() == 0) return;
+				if (neighbors.size() == 1)
+				{
+					node = neighbors[0];
+					offset = 0;
+					continue;
+				}
+				if (!takeBranches(neighbors.size(), kmer, kmerLength, branches)) return;
+				for (auto neighbor : neighbors)
+				{
+					removeFrom(neighbor, 0, kmer, kmerLength, branches);
+				}
+				return;
+			}
+			uint8_t mask = baseMask(graph.NodeSequences(node, offset));
+			if (mask == 1 || mask == 2 || mask == 4 || mask == 8)
+			{
+				kmer = (kmer << 2) + maskBase(mask);
+				kmerLength += 1;
+				offset += 1;
+				continue;
+			}
+			if (mask == 0) return;
+			if (!takeBranches(__builtin_popcount(mask), kmer, kmerLength, branches)) return;
+			for (uint64_t base = 0; base < 4; base++)
+			{
+				if (((mask >> base) & 1) == 0) continue;
+				removeFrom(node, offset+1, (kmer << 2) + base, kmerLength+1, branches);
+			}
+			return;
+		}
+		absent.erase(kmer);
+	}
+	//false if the search is given up here, then every read k-mer starting with the prefix so far counts as present
+	bool takeBranches(size_t count, uint64_t prefix, size_t prefixLength, size_t& branches)
+	{
+		if (count <= branches)
+		{
+			branches -= count;
+			return true;
+		}
+		for (auto iter = absent.begin(); iter != absent.end();)
+		{
+			if (prefixLength == 0 || (*iter >> ((k - prefixLength) * 2)) == prefix)
+			{
+				absent.erase(iter++);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+		return false;
+	}
+	uint64_t kmerMask() const
+	{
+		if (k == 32) return ~(uint64_t)0;
+		return ((uint64_t)1 << (k * 2)) - 1;
+	}
+	const AlignmentGraph& graph;
+	const size_t k;
+	phmap::flat_hash_set<uint64_t> absent;
+};
+
+#endif
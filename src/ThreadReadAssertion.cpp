@@ -18,6 +18,15 @@ namespace ThreadReadAssertion
 		std::cerr << msg.str() << std::endl;
 		std::abort();
 	}
+	Context getContext()
+	{
+		return Context { currentRead, currentnodeID, currentreverse, currentseqPos, currentmatchLen, currentnodeOffset };
+	}
+	void setContext(const Context& context)
+	{
+		currentRead = context.read;
+		setSeed(context.nodeID, context.reverse, context.seqPos, context.matchLen, context.nodeOffset);
+	}
 	void setRead(const std::string& readName)
 	{
 		currentRead = std::string_view(readName.data(), readName.size());
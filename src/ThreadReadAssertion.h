@@ -2,12 +2,26 @@
 #define ThreadReadAssertion_h
 
 #include <string>
+#include <string_view>
 
 namespace ThreadReadAssertion
 {
 	class AssertionFailure
 	{
 	};
+	//the read and seed named by assertion failures on this thread
+	class Context
+	{
+	public:
+		std::string_view read;
+		int nodeID;
+		bool reverse;
+		size_t seqPos;
+		size_t matchLen;
+		size_t nodeOffset;
+	};
+	Context getContext();
+	void setContext(const Context& context);
 	void setRead(const std::string& readName);
 	void setSeed(int nodeID, bool reverse, size_t seqPos, size_t matchLen, size_t nodeOffset);
 	void assertFailed(const char* expression, const char* file, int line);
@@ -1,8 +1,63 @@
 #include <algorithm>
 #include <fstream>
+#include <cstring>
 #include "fastqloader.h"
 #include "CommonUtils.h"
 
+LineBlockReader::LineBlockReader(std::istream& stream, size_t blockSize) :
+stream(stream),
+buffer(),
+pos(0),
+end(0),
+eof(false)
+{
+	buffer.resize(blockSize);
+}
+
+bool LineBlockReader::fill()
+{
+	if (eof) return false;
+	if (pos > 0)
+	{
+		memmove(buffer.data(), buffer.data() + pos, end - pos);
+		end -= pos;
+		pos = 0;
+	}
+	//line longer than the buffer
+	if (end == buffer.size()) buffer.resize(buffer.size() * 2);
+	stream.read(buffer.data() + end, buffer.size() - end);
+	size_t got = stream.gcount();
+	end += got;
+	if (got == 0) eof = true;
+	return got > 0;
+}
+
+bool LineBlockReader::nextLine(std::string_view& line)
+{
+	while (true)
+	{
+		const char* found = (const char*)memchr(buffer.data() + pos, '\n', end - pos);
+		if (found != nullptr)
+		{
+			size_t lineEnd = found - buffer.data();
+			size_t lineLength = lineEnd - pos;
+			if (lineLength > 0 && buffer[lineEnd-1] == '\r') lineLength--;
+			line = std::string_view { buffer.data() + pos, lineLength };
+			pos = lineEnd + 1;
+			return true;
+		}
+		if (!fill())
+		{
+			if (pos == end) return false;
+			size_t lineLength = end - pos;
+			if (buffer[end-1] == '\r') lineLength--;
+			line = std::string_view { buffer.data() + pos, lineLength };
+			pos = end;
+			return true;
+		}
+	}
+}
+
 std::vector<FastQ> loadFastqFromFile(std::string filename, bool includeQuality)
 {
 	std::vector<FastQ> result;
@@ -2,73 +2,73 @@
 #define FastqLoader_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <istream>
 #include <zstr.hpp> //https://github.com/mateidavid/zstr
 
+//reads the stream in large blocks and splits it into lines with memchr
+//returned lines point into the block buffer and are valid until the next call
+class LineBlockReader
+{
+public:
+	LineBlockReader(std::istream& stream, size_t blockSize = 1 << 22);
+	bool nextLine(std::string_view& line);
+private:
+	bool fill();
+	std::istream& stream;
+	std::vector<char> buffer;
+	size_t pos;
+	size_t end;
+	bool eof;
+};
+
 class FastQ {
 public:
 	template <typename F>
 	static void streamFastqFastqFromStream(std::istream& file, bool includeQuality, F f)
 	{
-		do
+		LineBlockReader reader { file };
+		std::string_view line;
+		FastQ newread;
+		while (reader.nextLine(line))
 		{
-			std::string line;
-			std::getline(file, line);
-			if (!file.good()) break;
 			if (line.size() == 0) continue;
 			if (line[0] != '@') continue;
-			FastQ newread;
-			if (line.back() == '\r') line.pop_back();
-			newread.seq_id = line.substr(1);
-			std::getline(file, line);
-			if (line.back() == '\r') line.pop_back();
-			newread.sequence = line;
-			std::getline(file, line);
-			std::getline(file, line);
-			if (line.back() == '\r') line.pop_back();
-			if (includeQuality) newread.quality = line;
+			newread.seq_id.assign(line.data() + 1, line.size() - 1);
+			if (!reader.nextLine(line)) break;
+			newread.sequence.assign(line.data(), line.size());
+			if (!reader.nextLine(line)) break;
+			if (!reader.nextLine(line)) break;
+			if (includeQuality) newread.quality.assign(line.data(), line.size());
 			f(newread);
-		} while (file.good());
+		}
 	}
 	template <typename F>
 	static void streamFastqFastaFromStream(std::istream& file, bool includeQuality, F f)
 	{
-		std::string line;
-		std::getline(file, line);
-		do
+		LineBlockReader reader { file };
+		std::string_view line;
+		FastQ newread;
+		bool hasLine = reader.nextLine(line);
+		while (hasLine)
 		{
-			if (line.size() == 0)
+			if (line.size() == 0 || line[0] != '>')
 			{
-				std::getline(file, line);
+				hasLine = reader.nextLine(line);
 				continue;
 			}
-			if (line[0] != '>')
+			newread.seq_id.assign(line.data() + 1, line.size() - 1);
+			newread.sequence.clear();
+			while ((hasLine = reader.nextLine(line)))
 			{
-				std::getline(file, line);
-				continue;
-			}
-			FastQ newread;
-			if (line.back() == '\r') line.pop_back();
-			newread.seq_id = line.substr(1);
-			newread.sequence = "";
-			do
-			{
-				std::getline(file, line);
-				if (!file.good()) break;
 				if (line.size() == 0) continue;
 				if (line[0] == '>') break;
-				if (line.back() == '\r') line.pop_back();
-				newread.sequence += line;
-			} while (file.good());
-			if (includeQuality)
-			{
-				for (size_t i = 0; i < newread.sequence.size(); i++)
-				{
-					newread.quality += '!';
-				}
+				newread.sequence.append(line.data(), line.size());
 			}
+			if (includeQuality) newread.quality.assign(newread.sequence.size(), '!');
 			f(newread);
-		} while (file.good());
+		}
 	}
 	template <typename F>
 	static void streamFastqFastqFromFile(std::string filename, bool includeQuality, F f)
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "ColinearChaining.h"
+
+//compares the best chain score of ColinearChaining::getChains against a quadratic dynamic programming chainer
+//with the same scoring: an anchor scores weightPerBp for each of its bases past its predecessor's match end,
+//minus the diagonal difference to the predecessor
+
+std::vector<int64_t> referenceScores(const std::vector<ColinearChaining::Anchor>& anchors, int64_t weightPerBp, int64_t maxDiagonalDifference, size_t maxSeqGap)
+{
+	std::vector<size_t> order;
+	for (size_t i = 0; i < anchors.size(); i++)
+	{
+		order.push_back(i);
+	}
+	std::sort(order.begin(), order.end(), [&anchors](size_t left, size_t right) { return anchors[left].seqPos < anchors[right].seqPos; });
+	std::vector<int64_t> result;
+	result.resize(anchors.size());
+	for (size_t to : order)
+	{
+		result[to] = (int64_t)anchors[to].length * weightPerBp;
+		for (size_t from : order)
+		{
+			if (anchors[from].seqPos >= anchors[to].seqPos) break;
+			if (anchors[from].seqPos + maxSeqGap < anchors[to].seqPos) continue;
+			int64_t diagonalDifference = std::abs(anchors[to].diagonal - anchors[from].diagonal);
+			if (diagonalDifference > maxDiagonalDifference) continue;
+			int64_t fromEnd = anchors[from].seqPos + anchors[from].length;
+			int64_t toEnd = anchors[to].seqPos + anchors[to].length;
+			int64_t newBases = fromEnd <= (int64_t)anchors[to].seqPos ? (int64_t)anchors[to].length : toEnd - fromEnd;
+			result[to] = std::max(result[to], result[from] + newBases * weightPerBp - diagonalDifference);
+		}
+	}
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	size_t iterations = 2000;
+	if (argc > 1) iterations = std::stoull(argv[1]);
+	std::mt19937 rng { 3 };
+	const int64_t weightPerBp = 5;
+	const int64_t maxDiagonalDifference = 10;
+	const size_t maxSeqGap = 100;
+	size_t mismatches = 0;
+	for (size_t iteration = 0; iteration < iterations; iteration++)
+	{
+		//every other case has fixed length anchors like k-mer seeds, which overlap a lot
+		bool fixedLength = iteration % 2 == 1;
+		std::vector<ColinearChaining::Anchor> anchors;
+		size_t numAnchors = 1 + rng() % 60;
+		for (size_t i = 0; i < numAnchors; i++)
+		{
+			anchors.push_back(ColinearChaining::Anchor { rng() % 300, (int64_t)(rng() % 40) - 20, fixedLength ? 15 : 1 + rng() % 40 });
+		}
+		auto chains = ColinearChaining::getChains(anchors, weightPerBp, maxDiagonalDifference, maxSeqGap);
+		auto reference = referenceScores(anchors, weightPerBp, maxDiagonalDifference, maxSeqGap);
+		int64_t bestReference = *std::max_element(reference.begin(), reference.end());
+		size_t anchorsInChains = 0;
+		for (const auto& chain : chains)
+		{
+			anchorsInChains += chain.anchors.size();
+		}
+		if (chains.size() == 0 || chains[0].score != bestReference || anchorsInChains != anchors.size())
+		{
+			std::cerr << "case " << iteration << ": best chain score " << (chains.size() > 0 ? chains[0].score : 0) << ", reference " << bestReference << ", " << anchorsInChains << " of " << anchors.size() << " anchors in chains" << std::endl;
+			mismatches += 1;
+		}
+	}
+	//overlapping k-mers on one diagonal count each covered base once: 10 15-mers at stride 3 cover 42 bases
+	std::vector<ColinearChaining::Anchor> run;
+	for (size_t i = 0; i < 10; i++)
+	{
+		run.push_back(ColinearChaining::Anchor { i * 3, 0, 15 });
+	}
+	auto runChains = ColinearChaining::getChains(run, 1, maxDiagonalDifference, maxSeqGap);
+	if (runChains[0].score != 42)
+	{
+		std::cerr << "overlapping run: best chain score " << runChains[0].score << ", expected 42" << std::endl;
+		mismatches += 1;
+	}
+	std::cout << iterations << " random cases and one overlapping run, " << mismatches << " mismatches" << std::endl;
+	return mismatches == 0 ? 0 : 1;
+}
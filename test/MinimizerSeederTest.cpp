@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "BigraphToDigraph.h"
+#include "CommonUtils.h"
+#include "GfaGraph.h"
+#include "MinimizerSeeder.h"
+
+//checks MinimizerSeeder::getSeeds against the k-mer and minimizer extraction from before the block encoding,
+//and measures how many seeds per second getSeeds finds
+//the graph is a set of random nodes without edges so every node is indexed from its start
+//usage: MinimizerSeederTest [number of nodes] [number of reads]
+
+const size_t MinimizerLength = 19;
+const size_t WindowSize = 30;
+
+namespace Reference
+{
+	bool validChar(char c)
+	{
+		return c == 'A' || c == 'C' || c == 'G' || c == 'T' || c == 'a' || c == 'c' || c == 'g' || c == 't';
+	}
+
+	size_t charToInt(char c)
+	{
+		switch(c)
+		{
+			case 'a':
+			case 'A':
+				return 0;
+			case 'c':
+			case 'C':
+				return 1;
+			case 'g':
+			case 'G':
+				return 2;
+			case 't':
+			case 'T':
+				return 3;
+		}
+		return 0;
+	}
+
+	uint64_t hash(uint64_t key)
+	{
+		key = (~key) + (key << 21);
+		key = key ^ (key >> 24);
+		key = (key + (key << 3)) + (key << 8);
+		key = key ^ (key >> 14);
+		key = (key + (key << 2)) + (key << 4);
+		key = key ^ (key >> 28);
+		key = key + (key << 31);
+		return key;
+	}
+
+	//every valid k-mer, repeats of the same k-mer only once per window
+	std::vector<std::pair<size_t, uint64_t>> kmers(const std::string& str, size_t kmerLength, size_t windowSize)
+	{
+		const size_t realWindow = windowSize - kmerLength + 1;
+		const uint64_t mask = ~(0xFFFFFFFFFFFFFFFF << (kmerLength * 2));
+		std::vector<std::pair<size_t, uint64_t>> result;
+		uint64_t kmer = 0;
+		size_t validLength = 0;
+		uint64_t lastKmer = 0;
+		size_t lastPos = 0;
+		for (size_t i = 0; i < str.size(); i++)
+		{
+			if (!validChar(str[i]))
+			{
+				validLength = 0;
+				continue;
+			}
+			kmer = ((kmer << 2) | charToInt(str[i])) & mask;
+			validLength += 1;
+			if (validLength < kmerLength) continue;
+			if (validLength == kmerLength || lastKmer != kmer || lastPos + realWindow <= i)
+			{
+				result.emplace_back(i, kmer);
+				lastKmer = kmer;
+				lastPos = i;
+			}
+		}
+		return result;
+	}
+
+	//window minimizers with a deque, all tied minima of a window are reported
+	std::vector<std::pair<size_t, uint64_t>> minimizers(const std::string& str, size_t minimizerLength, size_t windowSize)
+	{
+		const size_t realWindow = windowSize - minimizerLength + 1;
+		const uint64_t mask = ~(0xFFFFFFFFFFFFFFFF << (minimizerLength * 2));
+		std::vector<std::pair<size_t, uint64_t>> result;
+		std::deque<std::tuple<size_t, uint64_t, uint64_t>> window;
+		uint64_t kmer = 0;
+		size_t validLength = 0;
+		for (size_t i = 0; i < str.size(); i++)
+		{
+			if (!validChar(str[i]))
+			{
+				validLength = 0;
+				window.clear();
+				continue;
+			}
+			kmer = ((kmer << 2) | charToInt(str[i])) & mask;
+			validLength += 1;
+			if (validLength < minimizerLength) continue;
+			uint64_t hashed = hash(kmer);
+			if (validLength <= windowSize)
+			{
+				while (!window.empty() && std::get<2>(window.back()) > hashed) window.pop_back();
+				window.emplace_back(i, kmer, hashed);
+				continue;
+			}
+			if (validLength == windowSize + 1)
+			{
+				while (!window.empty() && std::get<2>(window.back()) > hashed) window.pop_back();
+				window.emplace_back(i, kmer, hashed);
+				for (auto iter = window.begin(); iter != window.end() && std::get<2>(*iter) == std::get<2>(window.front()); ++iter)
+				{
+					result.emplace_back(std::get<0>(*iter), std::get<1>(*iter));
+				}
+				continue;
+			}
+			uint64_t oldMinimum = std::get<2>(window.front());
+			bool frontPopped = false;
+			while (!window.empty() && std::get<0>(window.front()) + realWindow <= i)
+			{
+				frontPopped = true;
+				window.pop_front();
+			}
+			if (frontPopped)
+			{
+				while (window.size() >= 2 && std::get<2>(window[0]) == std::get<2>(window[1])) window.pop_front();
+			}
+			while (!window.empty() && std::get<2>(window.back()) > hashed) window.pop_back();
+			window.emplace_back(i, kmer, hashed);
+			if (std::get<2>(window.front()) != oldMinimum)
+			{
+				for (auto iter = window.begin(); iter != window.end() && std::get<2>(*iter) == std::get<2>(window.front()); ++iter)
+				{
+					result.emplace_back(std::get<0>(*iter), std::get<1>(*iter));
+				}
+			}
+			else if (std::get<2>(window.back()) == std::get<2>(window.front()))
+			{
+				result.emplace_back(std::get<0>(window.back()), std::get<1>(window.back()));
+			}
+		}
+		return result;
+	}
+}
+
+//node id, reverse, node offset, read position
+typedef std::tuple<int, bool, size_t, size_t> SeedTuple;
+
+std::string randomSequence(std::mt19937& rng, size_t length)
+{
+	std::string result;
+	result.reserve(length);
+	for (size_t i = 0; i < length; i++)
+	{
+		//occasional short runs of Ns
+		if (rng() % 2000 == 0)
+		{
+			size_t runLength = 1 + rng() % 30;
+			for (size_t j = 0; j < runLength && result.size() < length; j++) result.push_back('N');
+			continue;
+		}
+		result.push_back("ACGT"[rng() % 4]);
+	}
+	result.resize(length);
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	size_t numNodes = 200;
+	size_t numReads = 2000;
+	if (argc > 1) numNodes = std::stoull(argv[1]);
+	if (argc > 2) numReads = std::stoull(argv[2]);
+	std::mt19937 rng { 5 };
+	GfaGraph gfa;
+	gfa.edgeOverlap = 0;
+	for (size_t i = 0; i < numNodes; i++)
+	{
+		gfa.nodes[i+1] = randomSequence(rng, 1000 + rng() % 20000);
+	}
+	AlignmentGraph graph = DirectedGraph::BuildFromGFA(gfa);
+	auto indexStart = std::chrono::steady_clock::now();
+	//keepLeastFrequentFraction 1 keeps practically every k-mer of a random graph, the reference doesn't drop any
+	MinimizerSeeder seeder { graph, MinimizerLength, WindowSize, 0, 1, 1.0, "", 0 };
+	auto indexEnd = std::chrono::steady_clock::now();
+
+	std::unordered_map<uint64_t, std::vector<std::tuple<int, bool, size_t>>> referenceIndex;
+	for (const auto& pair : gfa.nodes)
+	{
+		for (auto pos : Reference::minimizers(pair.second, MinimizerLength, WindowSize)) referenceIndex[pos.second].emplace_back(pair.first, false, pos.first);
+		for (auto pos : Reference::minimizers(CommonUtils::ReverseComplement(pair.second), MinimizerLength, WindowSize)) referenceIndex[pos.second].emplace_back(pair.first, true, pos.first);
+	}
+	std::vector<std::string> reads;
+	std::vector<int> nodeIds;
+	for (const auto& pair : gfa.nodes) nodeIds.push_back(pair.first);
+	for (size_t i = 0; i < numReads; i++)
+	{
+		const std::string& node = gfa.nodes.at(nodeIds[rng() % nodeIds.size()]);
+		//some reads are whole nodes so every indexed minimizer is looked up
+		size_t start = 0;
+		size_t length = node.size();
+		if (i % 10 != 0)
+		{
+			length = std::min(node.size(), (size_t)(500 + rng() % 5000));
+			start = rng() % (node.size() - length + 1);
+		}
+		std::string read = node.substr(start, length);
+		for (size_t j = 0; j < read.size() / 100; j++)
+		{
+			read[rng() % read.size()] = "ACGTN"[rng() % 5];
+		}
+		if (rng() % 2 == 1) read = CommonUtils::ReverseComplement(read);
+		reads.push_back(read);
+	}
+
+	size_t mismatches = 0;
+	size_t totalSeeds = 0;
+	size_t totalBp = 0;
+	std::chrono::steady_clock::duration seedingTime { 0 };
+	for (size_t i = 0; i < reads.size(); i++)
+	{
+		auto seedStart = std::chrono::steady_clock::now();
+		auto seeds = seeder.getSeeds(reads[i], -1);
+		seedingTime += std::chrono::steady_clock::now() - seedStart;
+		totalSeeds += seeds.size();
+		totalBp += reads[i].size();
+		std::vector<SeedTuple> got;
+		for (const auto& seed : seeds)
+		{
+			got.emplace_back(seed.nodeID, seed.reverse, seed.nodeOffset, seed.seqPos);
+		}
+		std::vector<SeedTuple> expected;
+		for (auto kmer : Reference::kmers(reads[i], MinimizerLength, WindowSize))
+		{
+			auto found = referenceIndex.find(kmer.second);
+			if (found == referenceIndex.end()) continue;
+			for (auto pos : found->second)
+			{
+				expected.emplace_back(std::get<0>(pos), std::get<1>(pos), std::get<2>(pos), kmer.first);
+			}
+		}
+		std::sort(got.begin(), got.end());
+		std::sort(expected.begin(), expected.end());
+		if (got != expected)
+		{
+			std::cerr << "read " << i << ": " << got.size() << " seeds, reference has " << expected.size() << std::endl;
+			mismatches += 1;
+		}
+	}
+	double indexSeconds = std::chrono::duration_cast<std::chrono::duration<double>>(indexEnd - indexStart).count();
+	double seedingSeconds = std::chrono::duration_cast<std::chrono::duration<double>>(seedingTime).count();
+	std::cout << "index " << graph.SizeInBP() << " bp in " << indexSeconds << " s" << std::endl;
+	std::cout << "seeding " << reads.size() << " reads, " << totalBp << " bp, " << totalSeeds << " seeds in " << seedingSeconds << " s, " << (size_t)(totalSeeds / seedingSeconds) << " seeds/s, " << (size_t)(totalBp / seedingSeconds) << " bp/s" << std::endl;
+	std::cout << mismatches << " reads with different seeds than the reference" << std::endl;
+	return mismatches == 0 ? 0 : 1;
+}